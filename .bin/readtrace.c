@@ -0,0 +1,63 @@
+/// Program that prints the events recorded by `nachos -tr`.
+///
+/// Copyright (c) 2018 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#include "trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+int
+main(int argc, char *argv[]) {
+    const char *path = argc < 2 ? "nachos.trace" : argv[1];
+    if (argc > 2) {
+        fprintf(stderr, "Usage: %s [<path to trace file>]\n", argv[0]);
+        return 1;
+    }
+
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return 1;
+    }
+
+    traceHeader h;
+    if (fread(&h, sizeof h, 1, f) != 1) {
+        perror(path);
+        fclose(f);
+        return 1;
+    }
+    if (h.magic != TRACE_MAGIC || h.version != TRACE_VERSION
+          || h.recordSize != sizeof (traceRecord)) {
+        fprintf(stderr, "%s: not a trace file of this version of Nachos\n",
+                path);
+        fclose(f);
+        return 1;
+    }
+
+    if (h.recorded > h.count)
+        printf("(%llu earlier events were overwritten)\n",
+               h.recorded - h.count);
+
+    traceRecord r;
+    for (unsigned i = 0; i < h.count; i++) {
+        if (fread(&r, sizeof r, 1, f) != 1) {
+            fprintf(stderr, "%s: truncated after %u events\n", path, i);
+            fclose(f);
+            return 1;
+        }
+        if (r.event >= NUM_TRACE_EVENTS) {
+            printf("%12llu     unknown event %u\n", r.ticks, r.event);
+            continue;
+        }
+        printf("%12llu [%c] ", r.ticks, TRACE_EVENTS[r.event].flag);
+        printf(TRACE_EVENTS[r.event].format,
+               r.args[0], r.args[1], r.args[2]);
+        printf("\n");
+    }
+
+    fclose(f);
+    return 0;
+}
@@ -0,0 +1,62 @@
+/// Layout of the trace files written by Nachos (see `lib/trace.hh`), shared
+/// with `readtrace`, which turns them into text.
+///
+/// A trace file is a `traceHeader` followed by `count` records, oldest
+/// first.  Numbers are stored with the byte order of the host that wrote
+/// them.
+///
+/// Copyright (c) 2018 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_BIN_TRACE__H
+#define NACHOS_BIN_TRACE__H
+
+#define TRACE_MAGIC    0x4E545243  // “NTRC”.
+#define TRACE_VERSION  1
+
+/// Kinds of events, with what their three arguments stand for.
+enum traceEvent {
+    TRACE_INTERRUPT,  ///< Interrupt type, time it was due.
+    TRACE_FETCH,      ///< PC, instruction word.
+    TRACE_EXCEPTION,  ///< Exception type, bad virtual address.
+    TRACE_TRANSLATE,  ///< Virtual address, physical address, writing.
+                      ///< Accesses that hit the translation caches of the
+                      ///< MMU are not translated again.
+    TRACE_READ,       ///< Virtual address, size, value.
+    TRACE_WRITE,      ///< Virtual address, size, value.
+    TRACE_SYSCALL,    ///< System call number, first two arguments.
+    NUM_TRACE_EVENTS
+};
+
+/// Debug flag that enables each event, and how to print it.  Indexed by
+/// `traceEvent`.
+static const struct traceEventInfo {
+    char flag;
+    const char *format;
+} TRACE_EVENTS[NUM_TRACE_EVENTS] = {
+    { 'i', "interrupt type %u, due at %u" },
+    { 'm', "fetch at 0x%X: 0x%08X" },
+    { 'm', "exception type %u, bad address 0x%X" },
+    { 'A', "translate 0x%X to 0x%X, writing %u" },
+    { 'A', "read 0x%X, size %u: 0x%X" },
+    { 'A', "write 0x%X, size %u: 0x%X" },
+    { 'y', "system call %u, arguments 0x%X 0x%X" },
+};
+
+typedef struct {
+    unsigned           magic;       ///< Must be `TRACE_MAGIC`.
+    unsigned           version;     ///< Must be `TRACE_VERSION`.
+    unsigned           recordSize;  ///< Must be `sizeof (traceRecord)`.
+    unsigned           count;       ///< Records in the file.
+    unsigned long long recorded;    ///< Records ever taken; those beyond
+                                    ///< `count` were overwritten.
+} traceHeader;
+
+typedef struct {
+    unsigned long long ticks;  ///< Simulated time of the event.
+    unsigned           event;  ///< One of `traceEvent`.
+    unsigned           args[3];
+} traceRecord;
+
+#endif
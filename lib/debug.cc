@@ -17,15 +17,7 @@
 #include <unistd.h>
 
 Debug::Debug() {
-    flags = "";
-}
-
-bool
-Debug::IsEnabled(char flag) const {
-    if (flags)
-        return strchr(flags, flag) != 0 || strchr(flags, '+') != 0;
-    else
-        return false;
+    SetFlags("");
 }
 
 const char *
@@ -36,6 +28,17 @@ Debug::GetFlags() const {
 void
 Debug::SetFlags(const char *new_flags) {
     flags = new_flags;
+
+    enabled[0] = enabled[1] = 0;
+    if (!flags) return;
+    if (strchr(flags, '+')) {
+        enabled[0] = enabled[1] = ~0ULL;
+        return;
+    }
+    for (const char *f = flags; *f != '\0'; f++) {
+        unsigned char c = *f;
+        if (c < 128) enabled[c / 64] |= 1ULL << (c % 64);
+    }
 }
 
 void Bold(const char *org, char* dst) {
@@ -44,6 +47,11 @@ void Bold(const char *org, char* dst) {
             dst[strlen(dst)] = org[i];
         } else {
             dst = strcat(dst, BOLD "%");
+            // Copy flags, width, precision and length modifiers (as in
+            // `%llu`) along with the conversion itself.
+            while (org[i + 1] != '\0'
+                     && strchr("-+ #.0123456789hlLjzt", org[i + 1]))
+                dst[strlen(dst)] = org[++i];
             dst[strlen(dst)] = org[++i];
             dst = strcat(dst, DISABLE_BOLD);
         }
@@ -19,6 +19,7 @@
 /// * `k` -- network emulation (requires *NETWORK*).
 /// * `y` -- system calls.
 /// * `r` -- preemptive multitasking.
+/// * `x` -- binary translation (requires *BINARY_TRANSLATION*).
 ///
 /// Copyright (c) 1992-1993 The Regents of the University of California.
 ///               2016-2018 Docentes de la Universidad Nacional de Rosario.
@@ -70,9 +71,19 @@ private:
     /// String that controls which debug messages are printed.
     const char *flags;
 
+    /// Bit `flag % 64` of `enabled[flag / 64]` is set for every enabled
+    /// flag, so that checking a flag does not need to search `flags`.
+    unsigned long long enabled[2];
+
     /// Custom color for each flag.
     void Color(char flag) const;
 
 };
 
+inline bool
+Debug::IsEnabled(char flag) const {
+    unsigned char c = flag;
+    return c < 128 && (enabled[c / 64] >> (c % 64) & 1);
+}
+
 #endif
@@ -0,0 +1,186 @@
+/// A priority queue, kept as a binary heap.
+///
+/// Items come out in increasing order of their key, and items with equal
+/// keys come out in the same order they went in, just like with
+/// `List::SortedInsert` and `List::SortedPop`.  Looking at the first item
+/// takes constant time, and inserting or removing an item takes time
+/// logarithmic in the number of items.
+///
+/// Copyright (c) 2016-2019 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_LIB_HEAP__HH
+#define NACHOS_LIB_HEAP__HH
+
+#include "utility.hh"
+
+template <class Item, class Key>
+class Heap {
+public:
+
+    /// Initialize an empty heap.
+    Heap();
+
+    /// De-allocate the heap.  As with `List`, the items themselves are not
+    /// de-allocated.
+    ~Heap();
+
+    /// Put `item` into the heap, with priority `key`.
+    void Insert(Item item, Key key);
+
+    /// Remove the first item.
+    ///
+    /// Returns `Item()` if the heap is empty; otherwise, if `keyPtr` is
+    /// not null, stores the key of the removed item there.
+    Item Pop(Key *keyPtr);
+
+    /// Return the first item without removing it.
+    Item Head() const;
+
+    /// Return the key of the first item.
+    Key HeadKey() const;
+
+    /// Apply `func` to all items, in order.
+    void Apply(void (*func)(Item)) const;
+
+    bool IsEmpty() const;
+
+    unsigned Length() const;
+
+private:
+
+    struct Node {
+        Key key;
+        unsigned long long order;  ///< Insertion order, for equal keys.
+        Item item;
+    };
+
+    /// Return whether `a` must come out before `b`.
+    static bool Precedes(const Node &a, const Node &b);
+
+    /// Node `i` of the tree is `nodes[i]`; its children are `2 * i + 1` and
+    /// `2 * i + 2`.
+    Node *nodes;
+    unsigned size;
+    unsigned capacity;
+
+    unsigned long long inserted;  ///< Number of insertions so far.
+};
+
+template <class Item, class Key>
+Heap<Item, Key>::Heap() {
+    capacity = 16;
+    nodes    = new Node [capacity];
+    size     = 0;
+    inserted = 0;
+}
+
+template <class Item, class Key>
+Heap<Item, Key>::~Heap() {
+    delete [] nodes;
+}
+
+template <class Item, class Key>
+bool
+Heap<Item, Key>::Precedes(const Node &a, const Node &b) {
+    return a.key < b.key || (a.key == b.key && a.order < b.order);
+}
+
+template <class Item, class Key>
+void
+Heap<Item, Key>::Insert(Item item, Key key) {
+    if (size == capacity) {
+        Node *old = nodes;
+        capacity *= 2;
+        nodes = new Node [capacity];
+        for (unsigned i = 0; i < size; i++) nodes[i] = old[i];
+        delete [] old;
+    }
+
+    Node node;
+    node.key   = key;
+    node.order = inserted++;
+    node.item  = item;
+
+    // Move parents down until the place of the new node is found.
+    unsigned i = size++;
+    while (i > 0 && Precedes(node, nodes[(i - 1) / 2])) {
+        nodes[i] = nodes[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    nodes[i] = node;
+}
+
+template <class Item, class Key>
+Item
+Heap<Item, Key>::Pop(Key *keyPtr) {
+    if (IsEmpty()) return Item();
+
+    Item thing = nodes[0].item;
+    if (keyPtr) *keyPtr = nodes[0].key;
+
+    // Move the last node to the root, and let it sink to its place.
+    Node last = nodes[--size];
+    unsigned i = 0;
+    for (;;) {
+        unsigned child = 2 * i + 1;
+        if (child >= size) break;
+        if (child + 1 < size && Precedes(nodes[child + 1], nodes[child]))
+            child++;
+        if (!Precedes(nodes[child], last)) break;
+        nodes[i] = nodes[child];
+        i = child;
+    }
+    nodes[i] = last;
+
+    return thing;
+}
+
+template <class Item, class Key>
+Item
+Heap<Item, Key>::Head() const {
+    ASSERT(!IsEmpty());
+
+    return nodes[0].item;
+}
+
+template <class Item, class Key>
+Key
+Heap<Item, Key>::HeadKey() const {
+    ASSERT(!IsEmpty());
+
+    return nodes[0].key;
+}
+
+/// Meant for debugging, so it just sorts a copy of the nodes.
+template <class Item, class Key>
+void
+Heap<Item, Key>::Apply(void (*func)(Item)) const {
+    ASSERT(func);
+
+    Node *sorted = new Node [size];
+    for (unsigned i = 0; i < size; i++) {
+        unsigned j = i;
+        for (; j > 0 && Precedes(nodes[i], sorted[j - 1]); j--)
+            sorted[j] = sorted[j - 1];
+        sorted[j] = nodes[i];
+    }
+    for (unsigned i = 0; i < size; i++) func(sorted[i].item);
+
+    delete [] sorted;
+}
+
+template <class Item, class Key>
+bool
+Heap<Item, Key>::IsEmpty() const {
+    return size == 0;
+}
+
+template <class Item, class Key>
+unsigned
+Heap<Item, Key>::Length() const {
+    return size;
+}
+
+#endif
@@ -0,0 +1,73 @@
+/// Binary tracing of frequent events.
+///
+/// Copyright (c) 2018 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#include "trace.hh"
+#include "utility.hh"
+
+#include <stdio.h>
+#include <string.h>
+
+Trace trace;
+
+Trace::Trace() {
+    enabled  = 0;
+    records  = nullptr;
+    mask     = 0;
+    next     = 0;
+    ticks    = nullptr;
+    fileName = nullptr;
+}
+
+Trace::~Trace() {
+    delete [] records;
+}
+
+void
+Trace::Start(const char *flags, const char *name,
+             const unsigned long long *clock, unsigned capacity) {
+    ASSERT(flags);
+    ASSERT(name);
+    ASSERT(clock);
+    ASSERT(capacity > 0 && (capacity & (capacity - 1)) == 0);
+
+    delete [] records;
+    records  = new traceRecord [capacity];
+    mask     = capacity - 1;
+    next     = 0;
+    ticks    = clock;
+    fileName = name;
+
+    enabled = 0;
+    for (unsigned e = 0; e < NUM_TRACE_EVENTS; e++)
+        if (strchr(flags, TRACE_EVENTS[e].flag) || strchr(flags, '+'))
+            enabled |= 1 << e;
+}
+
+void
+Trace::Save() const {
+    if (!fileName) return;
+
+    FILE *f = fopen(fileName, "wb");
+    if (!f) {
+        perror(fileName);
+        return;
+    }
+
+    traceHeader h;
+    h.magic      = TRACE_MAGIC;
+    h.version    = TRACE_VERSION;
+    h.recordSize = sizeof (traceRecord);
+    h.count      = next > mask ? mask + 1 : next;
+    h.recorded   = next;
+    fwrite(&h, sizeof h, 1, f);
+
+    // Oldest first: if the buffer wrapped around, it starts right after
+    // the newest one.
+    for (unsigned long long i = next - h.count; i < next; i++)
+        fwrite(&records[i & mask], sizeof *records, 1, f);
+
+    fclose(f);
+}
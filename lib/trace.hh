@@ -0,0 +1,93 @@
+/// Binary tracing of frequent events.
+///
+/// Messages printed with `DEBUG` are too slow for events that happen on
+/// every instruction or memory access.  Trace points instead store a small
+/// fixed-size record (the event, the simulated time and three numbers) in a
+/// ring buffer, which only keeps the latest records.  When Nachos halts,
+/// the buffer is written to a file, which `.bin/readtrace` turns into text.
+///
+/// Trace points are enabled with the debug flag of their event (see
+/// `.bin/trace.h`), given to `-tr`.  A disabled trace point costs a test of
+/// a bit mask; compiling with `NO_TRACE` defined removes trace points
+/// altogether.
+///
+/// Copyright (c) 2018 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_LIB_TRACE__HH
+#define NACHOS_LIB_TRACE__HH
+
+#include ".bin/trace.h"
+
+class Trace {
+public:
+
+    /// Tracing starts disabled.
+    Trace();
+
+    ~Trace();
+
+    /// Start recording the events enabled by the debug flags in `flags`,
+    /// to be saved into the file `fileName`.
+    ///
+    /// * `clock` is where the current simulated time is kept.
+    /// * `capacity` is the number of records kept; it must be a power of
+    ///   two.
+    void Start(const char *flags, const char *fileName,
+               const unsigned long long *clock, unsigned capacity);
+
+    /// Is `event` being recorded?
+    bool IsEnabled(unsigned event) const;
+
+    /// Record `event`, overwriting the oldest record if the buffer is full.
+    void Record(unsigned event, unsigned a, unsigned b, unsigned c);
+
+    /// Write the records kept into the file given to `Start`, if any.
+    void Save() const;
+
+private:
+
+    unsigned enabled;  ///< Bit `1 << event` is set for recorded events.
+
+    traceRecord *records;
+    unsigned mask;  ///< The capacity of `records`, minus one.
+
+    /// Records ever taken.  The next one goes into `records[next & mask]`.
+    unsigned long long next;
+
+    const unsigned long long *ticks;
+    const char *fileName;
+};
+
+inline bool
+Trace::IsEnabled(unsigned event) const {
+    return enabled >> event & 1;
+}
+
+/// Nachos runs on a single host thread, so the buffer needs no lock:
+/// interrupt handlers only run between events, never in the middle of one.
+inline void
+Trace::Record(unsigned event, unsigned a, unsigned b, unsigned c) {
+    traceRecord *r = &records[next++ & mask];
+    r->ticks   = *ticks;
+    r->event   = event;
+    r->args[0] = a;
+    r->args[1] = b;
+    r->args[2] = c;
+}
+
+/// Global object for tracing.
+extern Trace trace;
+
+#ifdef NO_TRACE
+#define TRACE(event, a, b, c)  ((void) 0)
+#else
+/// Record `event` with arguments `a`, `b` and `c`, if it is enabled.  The
+/// arguments are not evaluated otherwise.
+#define TRACE(event, a, b, c)                                          \
+    (trace.IsEnabled(event) ? trace.Record((event), (a), (b), (c))    \
+                            : (void) 0)
+#endif
+
+#endif
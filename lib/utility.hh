@@ -12,6 +12,7 @@
 
 #include "colors.hh"
 #include "debug.hh"
+#include "trace.hh"
 
 /// Miscellaneous useful routines.
 
@@ -64,10 +65,22 @@ typedef void (*VoidNoArgFunctionPtr)();
 extern Debug debug;
 extern void PrintByte(char byte);
 
-#define DEBUG_ERROR(...)      (debug.Print)(true, __LINE__, __FILE__, __VA_ARGS__)
-#define DEBUG_CONT_ERROR(...) (debug.PrintCont)(true, __VA_ARGS__)
-#define DEBUG(...)            (debug.Print)(false, __LINE__, __FILE__, __VA_ARGS__)
-#define DEBUG_CONT(...)       (debug.PrintCont)(false, __VA_ARGS__)
+// The flag is checked before calling, so that disabled messages do not
+// cost a call with a variable number of arguments.
+#define DEBUG_ERROR(flag, ...)                                            \
+    (debug.IsEnabled(flag)                                                \
+       ? (debug.Print)(true, __LINE__, __FILE__, (flag), __VA_ARGS__)     \
+       : (void) 0)
+#define DEBUG_CONT_ERROR(flag, ...)                                       \
+    (debug.IsEnabled(flag) ? (debug.PrintCont)(true, (flag), __VA_ARGS__) \
+                           : (void) 0)
+#define DEBUG(flag, ...)                                                  \
+    (debug.IsEnabled(flag)                                                \
+       ? (debug.Print)(false, __LINE__, __FILE__, (flag), __VA_ARGS__)    \
+       : (void) 0)
+#define DEBUG_CONT(flag, ...)                                             \
+    (debug.IsEnabled(flag) ? (debug.PrintCont)(false, (flag), __VA_ARGS__) \
+                           : (void) 0)
 
 #define ERROR(string) UNDERLINE string DISABLE_UNDERLINE
 
@@ -0,0 +1,53 @@
+/// Arithmetic of the simulated MIPS processor that the host does not do
+/// the same way by itself: double-length products, and signed additions
+/// and subtractions that trap on overflow.
+///
+/// Kept apart from the simulator so that `-ta` can compare it with the
+/// shift-and-add and sign-bit versions it replaced.
+///
+/// DO NOT CHANGE -- part of the machine emulation
+///
+/// Copyright (c) 2016-2019 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_MACHINE_ARITHMETIC__HH
+#define NACHOS_MACHINE_ARITHMETIC__HH
+
+#include "lib/utility.hh"
+
+/// Simulate R2000 multiplication.
+///
+/// The words at `*hiPtr` and `*loPtr` are overwritten with the double-length
+/// result of the multiplication, which the host computes in one 64-bit
+/// product.
+static inline void
+Mult(int a, int b, bool signedArith, int *hiPtr, int *loPtr) {
+    ASSERT(hiPtr);
+    ASSERT(loPtr);
+
+    unsigned long long product;
+    if (signedArith)
+        product = (unsigned long long) ((long long) a * b);
+    else
+        product = (unsigned long long) (unsigned) a * (unsigned) b;
+
+    *hiPtr = (int) (product >> 32);
+    *loPtr = (int) product;
+}
+
+/// Store `a + b` at `*sum`, wrapping around, and return whether the signed
+/// addition overflowed, as `ADD` and `ADDI` trap.
+static inline bool
+AddOverflows(int a, int b, int *sum) {
+    return __builtin_add_overflow(a, b, sum);
+}
+
+/// Store `a - b` at `*diff`, wrapping around, and return whether the signed
+/// subtraction overflowed, as `SUB` traps.
+static inline bool
+SubOverflows(int a, int b, int *diff) {
+    return __builtin_sub_overflow(a, b, diff);
+}
+
+#endif
@@ -0,0 +1,660 @@
+/// DO NOT CHANGE -- part of the machine emulation
+///
+/// Copyright (c) 2016-2019 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifdef BINARY_TRANSLATION
+
+#include ".binary_translator.hh"
+#include ".endianness.hh"
+#include "machine.hh"
+#include "threads/system.hh"
+
+#include <string.h>
+#include <sys/mman.h>
+
+/// Size of the executable arena.
+static const unsigned ARENA_SIZE = 4 << 20;
+
+/// Room that must be left in the arena before translating a block; more
+/// than the largest code a block of `MAX_BLOCK_LENGTH` instructions can
+/// take.
+static const unsigned MAX_BLOCK_CODE = 16 << 10;
+
+/// Host registers, numbered as in their encoding.
+enum {
+    EAX = 0, ECX = 1, EDX = 2, EBX = 3, ESI = 6,
+    R12 = 12, R13 = 13, R14 = 14
+};
+
+/// Condition codes, as in `jcc`, `setcc` and `cmovcc`.
+enum {
+    CC_O = 0x0, CC_B = 0x2, CC_E = 0x4, CC_NE = 0x5,
+    CC_L = 0xC, CC_GE = 0xD, CC_LE = 0xE, CC_G = 0xF
+};
+
+/// Opcodes of `op eax, [mem]` and of `op eax, imm32`.
+enum {
+    ALU_ADD = 0x03, ALU_OR = 0x0B, ALU_AND = 0x23, ALU_SUB = 0x2B,
+    ALU_XOR = 0x33, ALU_CMP = 0x3B
+};
+
+/// Just enough of an x86-64 assembler for the translator.
+///
+/// The generated code keeps the simulated registers pointed to by `rbx` and
+/// the MMU in `r12`; `r13d` holds the target of the branch of the block and
+/// `r14d` the value read by the load being executed.  All of them are
+/// callee-saved, so they survive calls into the MMU.
+class Assembler {
+public:
+    Assembler(uint8_t *start) {
+        cursor = start;
+    }
+
+    void Byte(unsigned b) {
+        *cursor++ = b;
+    }
+
+    void Word(uint32_t w) {
+        memcpy(cursor, &w, 4);
+        cursor += 4;
+    }
+
+    void Quad(uint64_t q) {
+        memcpy(cursor, &q, 8);
+        cursor += 8;
+    }
+
+    /// `op reg, [rbx + 4 * simReg]`.
+    void Mem(unsigned opcode, unsigned reg, unsigned simReg) {
+        if (reg >= 8) Byte(0x44);
+        Byte(opcode);
+        Byte(0x80 | (reg & 7) << 3 | EBX);
+        Word(4 * simReg);
+    }
+
+    /// Read simulated register `simReg` into `reg`.
+    void Load(unsigned reg, unsigned simReg) {
+        Mem(0x8B, reg, simReg);
+    }
+
+    /// Write `reg` into simulated register `simReg`.
+    void Store(unsigned simReg, unsigned reg) {
+        Mem(0x89, reg, simReg);
+    }
+
+    void StoreImm(unsigned simReg, uint32_t imm) {
+        Byte(0xC7);
+        Byte(0x80 | EBX);
+        Word(4 * simReg);
+        Word(imm);
+    }
+
+    /// `mov dst, src`, 32 bits.
+    void Move(unsigned dst, unsigned src) {
+        unsigned rex = (src >= 8 ? 0x44 : 0) | (dst >= 8 ? 0x41 : 0);
+        if (rex) Byte(rex);
+        Byte(0x89);
+        Byte(0xC0 | (src & 7) << 3 | (dst & 7));
+    }
+
+    void MoveImm(unsigned reg, uint32_t imm) {
+        if (reg >= 8) Byte(0x41);
+        Byte(0xB8 | (reg & 7));
+        Word(imm);
+    }
+
+    /// `op eax, [rbx + 4 * simReg]`.
+    void Alu(unsigned opcode, unsigned simReg) {
+        Mem(opcode, EAX, simReg);
+    }
+
+    /// `op eax, imm32`; the short form for `eax` is the memory opcode plus
+    /// two.
+    void AluImm(unsigned opcode, uint32_t imm) {
+        Byte(opcode + 2);
+        Word(imm);
+    }
+
+    /// `shl`/`sar eax, imm8` (`ext` is 4 and 7 respectively).
+    void Shift(unsigned ext, unsigned count) {
+        Byte(0xC1);
+        Byte(0xC0 | ext << 3 | EAX);
+        Byte(count);
+    }
+
+    /// `shl`/`sar eax, cl`.
+    void ShiftCl(unsigned ext) {
+        Byte(0xD3);
+        Byte(0xC0 | ext << 3 | EAX);
+    }
+
+    /// `eax = cc ? 1 : 0`.
+    void Set(unsigned cc) {
+        Byte(0x0F); Byte(0x90 | cc); Byte(0xC0);  // setcc al
+        Byte(0x0F); Byte(0xB6); Byte(0xC0);       // movzx eax, al
+    }
+
+    /// `cmovcc r13d, ecx`.
+    void MoveIf(unsigned cc) {
+        Byte(0x44); Byte(0x0F); Byte(0x40 | cc); Byte(0xE9);
+    }
+
+    /// `call fn`, with the MMU as first argument.
+    void Call(const void *fn) {
+        Byte(0x4C); Byte(0x89); Byte(0xE7);  // mov rdi, r12
+        Byte(0x48); Byte(0xB8);              // mov rax, fn
+        Quad((uint64_t) fn);
+        Byte(0xFF); Byte(0xD0);              // call rax
+    }
+
+    /// Jump if `cc`, to be patched later.  Returns the displacement field.
+    uint8_t *JumpIf(unsigned cc) {
+        Byte(0x0F);
+        Byte(0x80 | cc);
+        Word(0);
+        return cursor - 4;
+    }
+
+    uint8_t *Jump() {
+        Byte(0xE9);
+        Word(0);
+        return cursor - 4;
+    }
+
+    static void Patch(uint8_t *field, const uint8_t *target) {
+        int32_t disp = target - (field + 4);
+        memcpy(field, &disp, 4);
+    }
+
+    uint8_t *cursor;
+};
+
+/// Memory accesses from the generated code.
+///
+/// They never raise exceptions: the generated code gives up on the
+/// instruction instead, and the interpreter runs it again.
+
+static const uint64_t ACCESS_FAILED = 1ULL << 32;
+
+static uint64_t
+LoadHelper(MMU *mmu, unsigned addr, unsigned size) {
+    int value;
+    if (mmu->ReadMem(addr, size, &value) != NO_EXCEPTION) return ACCESS_FAILED;
+    return (unsigned) value;
+}
+
+static int
+StoreHelper(MMU *mmu, unsigned addr, unsigned size, int value) {
+    return mmu->WriteMem(addr, size, value);
+}
+
+static bool
+IsTranslatable(unsigned op) {
+    switch (op) {
+        case OP_DIV: case OP_DIVU:
+        case OP_LWL: case OP_LWR: case OP_SWL: case OP_SWR:
+        case OP_SYSCALL: case OP_RES: case OP_UNIMP:
+            return false;
+        default:
+            return op > 0 && op <= MAX_OPCODE;
+    }
+}
+
+static bool
+IsBranch(unsigned op) {
+    switch (op) {
+        case OP_BEQ: case OP_BNE: case OP_BGEZ: case OP_BGEZAL:
+        case OP_BGTZ: case OP_BLEZ: case OP_BLTZ: case OP_BLTZAL:
+        case OP_J: case OP_JAL: case OP_JR: case OP_JALR:
+            return true;
+        default:
+            return false;
+    }
+}
+
+BinaryTranslator::BinaryTranslator(MMU *m, int *regs, DecodeCache *cache) {
+    ASSERT(m);
+    ASSERT(regs);
+    ASSERT(cache);
+
+    mmu         = m;
+    registers   = regs;
+    decodeCache = cache;
+
+    void *mem = mmap(nullptr, ARENA_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    ASSERT(mem != MAP_FAILED);
+    arena = arenaFree = (uint8_t *) mem;
+
+    numEntries = mmu->GetMemorySize() / 4;
+    blocks     = (Block **) AllocZeroedArray(numEntries * sizeof *blocks);
+    counts     = (unsigned char *) AllocZeroedArray(numEntries);
+    afterBlock = false;
+}
+
+BinaryTranslator::~BinaryTranslator() {
+    Flush();
+    DeallocZeroedArray((char *) blocks, numEntries * sizeof *blocks);
+    DeallocZeroedArray((char *) counts, numEntries);
+    munmap(arena, ARENA_SIZE);
+}
+
+/// Only entries in use are written, so that the pages of `blocks` and
+/// `counts` that were never touched stay that way.
+void
+BinaryTranslator::Flush() {
+    DEBUG('x', "Flushing translated code.\n");
+    for (unsigned i = 0; i < numEntries; i++) {
+        if (blocks[i]) {
+            delete blocks[i];
+            blocks[i] = nullptr;
+        }
+        if (counts[i]) counts[i] = 0;
+    }
+    arenaFree = arena;
+}
+
+bool
+BinaryTranslator::Execute() {
+    unsigned pc = registers[PC_REG];
+
+    // Only look for blocks where control was transferred, and never in the
+    // middle of a delay slot.
+    bool leader = afterBlock || pc != (unsigned) registers[PREV_PC_REG] + 4;
+    afterBlock = false;
+    if (!leader || (unsigned) registers[NEXT_PC_REG] != pc + 4) return false;
+
+    unsigned physAddr;
+    if (mmu->Translate(pc, &physAddr, 4, false) != NO_EXCEPTION)
+        return false;  // Let the interpreter raise the exception.
+
+    unsigned index = physAddr / 4;
+    Block *block = blocks[index];
+    if (block && (block->virtAddr != pc
+                  || memcmp(block->words, &mmu->mainMemory[physAddr],
+                            block->length * 4) != 0)) {
+        // The frame holds different code now, or is mapped elsewhere.
+        delete block;
+        block = blocks[index] = nullptr;
+        counts[index] = 0;
+    }
+    if (!block) {
+        if (++counts[index] < HOT_THRESHOLD) return false;
+        block = blocks[index] = Translate(pc, physAddr);
+    }
+
+    // The clock is not checked inside the block, so no interrupt may fall
+    // due before its last instruction.
+    unsigned long long due = interrupt->NextDue();
+    if (block->length == 0 || due <= stats->totalTicks
+          || due - stats->totalTicks < block->length)
+        return false;
+
+    unsigned done = block->code(registers, mmu);
+    if (done == block->length) {
+        interrupt->AdvanceUserTicks(done - 1);
+        afterBlock = true;
+        return true;
+    }
+    interrupt->AdvanceUserTicks(done);
+    return false;
+}
+
+BinaryTranslator::Block *
+BinaryTranslator::Translate(unsigned virtAddr, unsigned physAddr) {
+    if (arena + ARENA_SIZE - arenaFree < MAX_BLOCK_CODE) {
+        // Entries for the current block are reset too, which is harmless.
+        Flush();
+    }
+
+    Block *block = new Block;
+    block->virtAddr = virtAddr;
+    block->length = 0;
+    block->code = nullptr;
+
+    // Stop at the end of the page: the next one may be mapped anywhere.
+    unsigned pageSize = mmu->GetPageSize();
+    unsigned limit = (pageSize - physAddr % pageSize) / 4;
+    if (limit > MAX_BLOCK_LENGTH) limit = MAX_BLOCK_LENGTH;
+
+    Instruction instrs[MAX_BLOCK_LENGTH];
+    unsigned length = 0;
+    for (unsigned i = 0; i < limit; i++) {
+        unsigned *word = (unsigned *) &mmu->mainMemory[physAddr + 4 * i];
+        block->words[i] = *word;
+        instrs[i] = *decodeCache->Lookup(physAddr + 4 * i, WordToHost(*word));
+        unsigned op = instrs[i].opCode;
+
+        if (!IsTranslatable(op)
+              || (i > 0 && IsBranch(instrs[i - 1].opCode) && IsBranch(op)))
+            break;
+        if (i > 0 && IsBranch(instrs[i - 1].opCode)) {
+            length = i + 1;  // The delay slot closes the block.
+            break;
+        }
+        if (!IsBranch(op)) length = i + 1;
+    }
+
+    block->length = length;
+    if (length > 0) block->code = Emit(instrs, length, virtAddr);
+
+    DEBUG('x', "Translated block at 0x%X, %u instructions.\n",
+          virtAddr, length);
+    return block;
+}
+
+BinaryTranslator::BlockCode
+BinaryTranslator::Emit(const Instruction *instrs, unsigned length,
+                       unsigned virtAddr) {
+    Assembler a(arenaFree);
+    BlockCode code = (BlockCode) arenaFree;
+
+    // Side exits: jumps to be patched to return the index of the
+    // instruction they leave at.
+    uint8_t *exits[4 * MAX_BLOCK_LENGTH];
+    unsigned exitIndex[4 * MAX_BLOCK_LENGTH];
+    unsigned numExits = 0;
+
+    a.Byte(0x53);                                   // push rbx
+    a.Byte(0x41); a.Byte(0x54);                     // push r12
+    a.Byte(0x41); a.Byte(0x55);                     // push r13
+    a.Byte(0x41); a.Byte(0x56);                     // push r14
+    a.Byte(0x48); a.Byte(0x83); a.Byte(0xEC); a.Byte(0x08);  // sub rsp, 8
+    a.Byte(0x48); a.Byte(0x89); a.Byte(0xFB);       // mov rbx, rdi
+    a.Byte(0x49); a.Byte(0x89); a.Byte(0xF4);       // mov r12, rsi
+
+    bool prevLoad = false;
+    unsigned prevLoadReg = 0;
+    bool inDelaySlot = false;
+
+    for (unsigned i = 0; i < length; i++) {
+        const Instruction *instr = &instrs[i];
+        unsigned pc = virtAddr + 4 * i;
+        unsigned target = pc + 4 + IndexToAddr(instr->extra);
+        bool load = false;
+        bool branch = false;
+        unsigned size = 4;
+        unsigned cc = CC_E;
+
+        // Writes to register 0 are dropped: the interpreter clears it
+        // again before the next instruction anyway.
+#define STORE(reg)  do { if (reg != 0) a.Store(reg, EAX); } while (0)
+#define EXIT_IF(c)  do { exits[numExits] = a.JumpIf(c); \
+                         exitIndex[numExits++] = i; } while (0)
+
+        switch (instr->opCode) {
+            case OP_ADD:
+            case OP_SUB:
+                a.Load(EAX, instr->rs);
+                a.Alu(instr->opCode == OP_ADD ? ALU_ADD : ALU_SUB, instr->rt);
+                EXIT_IF(CC_O);
+                STORE(instr->rd);
+                break;
+
+            case OP_ADDI:
+                a.Load(EAX, instr->rs);
+                a.AluImm(ALU_ADD, instr->extra);
+                EXIT_IF(CC_O);
+                STORE(instr->rt);
+                break;
+
+            case OP_ADDIU:
+                a.Load(EAX, instr->rs);
+                a.AluImm(ALU_ADD, instr->extra);
+                STORE(instr->rt);
+                break;
+
+            case OP_ADDU:
+            case OP_AND:
+            case OP_NOR:
+            case OP_OR:
+            case OP_SUBU:
+            case OP_XOR:
+                a.Load(EAX, instr->rs);
+                switch (instr->opCode) {
+                    case OP_ADDU: a.Alu(ALU_ADD, instr->rt); break;
+                    case OP_AND:  a.Alu(ALU_AND, instr->rt); break;
+                    case OP_SUBU: a.Alu(ALU_SUB, instr->rt); break;
+                    case OP_XOR:  a.Alu(ALU_XOR, instr->rt); break;
+                    default:      a.Alu(ALU_OR,  instr->rt); break;
+                }
+                if (instr->opCode == OP_NOR) {
+                    a.Byte(0xF7); a.Byte(0xD0);  // not eax
+                }
+                STORE(instr->rd);
+                break;
+
+            case OP_ANDI:
+            case OP_ORI:
+            case OP_XORI:
+                a.Load(EAX, instr->rs);
+                a.AluImm(instr->opCode == OP_ANDI ? ALU_AND
+                         : instr->opCode == OP_ORI ? ALU_OR : ALU_XOR,
+                         instr->extra & 0xFFFF);
+                STORE(instr->rt);
+                break;
+
+            case OP_LUI:
+                if (instr->rt != 0) a.StoreImm(instr->rt, instr->extra << 16);
+                break;
+
+            // NOTE: `SRL` and `SRLV` shift arithmetically in the
+            // interpreter, and so they do here.
+            case OP_SLL:
+            case OP_SRA:
+            case OP_SRL:
+                a.Load(EAX, instr->rt);
+                a.Shift(instr->opCode == OP_SLL ? 4 : 7, instr->extra);
+                STORE(instr->rd);
+                break;
+
+            case OP_SLLV:
+            case OP_SRAV:
+            case OP_SRLV:
+                a.Load(EAX, instr->rt);
+                a.Load(ECX, instr->rs);  // The host masks the count too.
+                a.ShiftCl(instr->opCode == OP_SLLV ? 4 : 7);
+                STORE(instr->rd);
+                break;
+
+            case OP_SLT:
+            case OP_SLTU:
+                a.Load(EAX, instr->rs);
+                a.Alu(ALU_CMP, instr->rt);
+                a.Set(instr->opCode == OP_SLT ? CC_L : CC_B);
+                STORE(instr->rd);
+                break;
+
+            case OP_SLTI:
+            case OP_SLTIU:
+                a.Load(EAX, instr->rs);
+                a.AluImm(ALU_CMP, instr->extra);
+                a.Set(instr->opCode == OP_SLTI ? CC_L : CC_B);
+                STORE(instr->rt);
+                break;
+
+            case OP_MFHI:
+            case OP_MFLO:
+                a.Load(EAX, instr->opCode == OP_MFHI ? HI_REG : LO_REG);
+                STORE(instr->rd);
+                break;
+
+            case OP_MTHI:
+            case OP_MTLO:
+                a.Load(EAX, instr->rs);
+                a.Store(instr->opCode == OP_MTHI ? HI_REG : LO_REG, EAX);
+                break;
+
+            case OP_MULT:
+            case OP_MULTU:
+                a.Load(EAX, instr->rs);
+                a.Load(ECX, instr->rt);
+                a.Byte(0xF7);  // imul ecx / mul ecx
+                a.Byte(instr->opCode == OP_MULT ? 0xE9 : 0xE1);
+                a.Store(HI_REG, EDX);
+                a.Store(LO_REG, EAX);
+                break;
+
+            case OP_LB:
+            case OP_LBU:
+            case OP_LH:
+            case OP_LHU:
+            case OP_LW:
+                size = instr->opCode == OP_LW ? 4
+                     : instr->opCode == OP_LH || instr->opCode == OP_LHU ? 2
+                     : 1;
+                a.Load(ESI, instr->rs);
+                a.Byte(0x81); a.Byte(0xC6);  // add esi, imm32
+                a.Word(instr->extra);
+                a.MoveImm(EDX, size);
+                a.Call((const void *) LoadHelper);
+                a.Byte(0x48); a.Byte(0x0F); a.Byte(0xBA);  // bt rax, 32
+                a.Byte(0xE0); a.Byte(32);
+                EXIT_IF(CC_B);
+                if (instr->opCode != OP_LW) {
+                    a.Byte(0x0F);  // movsx/movzx eax, al/ax
+                    a.Byte(instr->opCode == OP_LB  ? 0xBE
+                         : instr->opCode == OP_LBU ? 0xB6
+                         : instr->opCode == OP_LH  ? 0xBF : 0xB7);
+                    a.Byte(0xC0);
+                }
+                a.Move(R14, EAX);
+                load = true;
+                break;
+
+            case OP_SB:
+            case OP_SH:
+            case OP_SW:
+                size = instr->opCode == OP_SW ? 4
+                     : instr->opCode == OP_SH ? 2 : 1;
+                a.Load(ESI, instr->rs);
+                a.Byte(0x81); a.Byte(0xC6);  // add esi, imm32
+                a.Word(instr->extra);
+                a.Load(ECX, instr->rt);
+                a.MoveImm(EDX, size);
+                a.Call((const void *) StoreHelper);
+                a.Byte(0x85); a.Byte(0xC0);  // test eax, eax
+                EXIT_IF(CC_NE);
+                break;
+
+            case OP_BGEZAL:
+            case OP_BLTZAL:
+                a.StoreImm(RET_ADDR_REG, pc + 8);
+                // Fall through.
+            case OP_BGEZ:
+            case OP_BGTZ:
+            case OP_BLEZ:
+            case OP_BLTZ:
+                cc = instr->opCode == OP_BGTZ ? CC_G
+                   : instr->opCode == OP_BLEZ ? CC_LE
+                   : instr->opCode == OP_BLTZ || instr->opCode == OP_BLTZAL
+                     ? CC_L : CC_GE;
+                a.Load(EAX, instr->rs);
+                a.AluImm(ALU_CMP, 0);
+                a.MoveImm(R13, pc + 8);
+                a.MoveImm(ECX, target);
+                a.MoveIf(cc);
+                branch = true;
+                break;
+
+            case OP_BEQ:
+            case OP_BNE:
+                a.Load(EAX, instr->rs);
+                a.Alu(ALU_CMP, instr->rt);
+                a.MoveImm(R13, pc + 8);
+                a.MoveImm(ECX, target);
+                a.MoveIf(instr->opCode == OP_BEQ ? CC_E : CC_NE);
+                branch = true;
+                break;
+
+            case OP_JAL:
+                a.StoreImm(RET_ADDR_REG, pc + 8);
+                // Fall through.
+            case OP_J:
+                a.MoveImm(R13, ((pc + 8) & 0xF0000000)
+                               | IndexToAddr(instr->extra));
+                branch = true;
+                break;
+
+            case OP_JALR:
+                // The interpreter links before reading the target, and so
+                // must we.
+                a.StoreImm(instr->rd, pc + 8);
+                a.Load(R13, instr->rs);
+                if (instr->rd == 0) a.StoreImm(0, 0);
+                branch = true;
+                break;
+
+            case OP_JR:
+                a.Load(R13, instr->rs);
+                branch = true;
+                break;
+
+            default:
+                ASSERT(false);
+        }
+#undef STORE
+#undef EXIT_IF
+
+        // Commit, as `Machine::DelayedLoad` does.  What is pending is only
+        // unknown for the first instruction; after that, there is something
+        // pending only after a load.
+        if (i == 0) {
+            a.Load(ECX, LOAD_REG);
+            a.Load(EAX, LOAD_VALUE_REG);
+            a.Byte(0x89); a.Byte(0x04); a.Byte(0x8B);  // mov [rbx+rcx*4], eax
+            a.StoreImm(0, 0);
+        } else if (prevLoad && prevLoadReg != 0) {
+            a.Load(EAX, LOAD_VALUE_REG);
+            a.Store(prevLoadReg, EAX);
+        }
+        if (load) {
+            a.StoreImm(LOAD_REG, instr->rt);
+            a.Store(LOAD_VALUE_REG, R14);
+        } else if (i == 0 || prevLoad) {
+            a.StoreImm(LOAD_REG, 0);
+            a.StoreImm(LOAD_VALUE_REG, 0);
+        }
+
+        // Advance program counters.
+        a.StoreImm(PREV_PC_REG, pc);
+        if (inDelaySlot) {
+            a.Store(PC_REG, R13);
+            a.Move(EAX, R13);
+            a.AluImm(ALU_ADD, 4);
+            a.Store(NEXT_PC_REG, EAX);
+        } else {
+            a.StoreImm(PC_REG, pc + 4);
+            if (branch) a.Store(NEXT_PC_REG, R13);
+            else a.StoreImm(NEXT_PC_REG, pc + 8);
+        }
+
+        prevLoad = load;
+        prevLoadReg = instr->rt;
+        inDelaySlot = branch;
+    }
+
+    // Normal end: every instruction completed.
+    a.MoveImm(EAX, length);
+    uint8_t *epilogue = a.cursor;
+    a.Byte(0x48); a.Byte(0x83); a.Byte(0xC4); a.Byte(0x08);  // add rsp, 8
+    a.Byte(0x41); a.Byte(0x5E);                     // pop r14
+    a.Byte(0x41); a.Byte(0x5D);                     // pop r13
+    a.Byte(0x41); a.Byte(0x5C);                     // pop r12
+    a.Byte(0x5B);                                   // pop rbx
+    a.Byte(0xC3);                                   // ret
+
+    for (unsigned e = 0; e < numExits; e++) {
+        Assembler::Patch(exits[e], a.cursor);
+        a.MoveImm(EAX, exitIndex[e]);
+        Assembler::Patch(a.Jump(), epilogue);
+    }
+
+    ASSERT(a.cursor - arenaFree <= MAX_BLOCK_CODE);
+    arenaFree = a.cursor;
+    return code;
+}
+
+#endif
@@ -0,0 +1,121 @@
+/// Translation of hot user code into host machine code.
+///
+/// The interpreter in `mips_sim.cc` pays for fetching, translating and
+/// dispatching every single instruction, and for checking interrupts after
+/// each of them.  Most of the time of a compute-bound program is spent in
+/// a few small loops, so the blocks of code starting at the targets of
+/// jumps are counted, and once a block has been entered `HOT_THRESHOLD`
+/// times it is translated into x86-64 code, which is run directly from
+/// then on.
+///
+/// A block is a run of straight-line instructions inside a single page,
+/// optionally ended by a branch or jump together with its delay slot.  The
+/// generated code works on the very same `registers` array as the
+/// interpreter, and stores the program counters and delayed load registers
+/// after each instruction, so the state it leaves behind is exactly the
+/// one the interpreter would have left.
+///
+/// Control goes back to the interpreter:
+/// * before any instruction that is not translated (system calls, divisions
+///   and unaligned loads and stores, among others);
+/// * when a memory access or an arithmetic instruction would raise an
+///   exception: the generated code stops right before the faulting
+///   instruction, and the interpreter runs it again, raising the exception
+///   as usual;
+/// * when an interrupt would fall due in the middle of the block: the block
+///   is only entered if no pending interrupt is due before its last
+///   instruction, and the last instruction is ticked by `Machine::Run` as
+///   any other, so interrupts fire at exactly the same simulated times.
+///
+/// Only available on x86-64 hosts, when Nachos is built with
+/// *BINARY_TRANSLATION*.
+///
+/// DO NOT CHANGE -- part of the machine emulation
+///
+/// Copyright (c) 2016-2019 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_MACHINE_BINARYTRANSLATOR__HH
+#define NACHOS_MACHINE_BINARYTRANSLATOR__HH
+
+#if defined(BINARY_TRANSLATION) && !defined(HOST_x86_64)
+#error "Binary translation is only supported on x86-64 hosts."
+#endif
+
+#include ".decode_cache.hh"
+#include "mmu.hh"
+
+#include <stdint.h>
+
+class BinaryTranslator {
+public:
+
+    /// Create a translator for the code found in `mmu`'s memory, running
+    /// on the register set `registers`.
+    BinaryTranslator(MMU *m, int *regs, DecodeCache *cache);
+
+    ~BinaryTranslator();
+
+    /// Run the translated block starting at the program counter, if there
+    /// is one, translating it first if it just became hot.
+    ///
+    /// Returns true if the whole block was run.  The clock has then been
+    /// advanced for every instruction of the block but the last one, which
+    /// the caller must tick.  Returns false if the next instruction has to
+    /// be interpreted; the instructions run up to that point, if any, have
+    /// already been accounted for.
+    bool Execute();
+
+private:
+
+    /// Number of entries into a block before it gets translated.
+    static const unsigned HOT_THRESHOLD = 16;
+
+    /// Maximum number of instructions in a block.
+    static const unsigned MAX_BLOCK_LENGTH = 64;
+
+    /// Generated code is called with the register set and the MMU, and
+    /// returns how many instructions it completed.
+    typedef unsigned (*BlockCode)(int *registers, MMU *mmu);
+
+    struct Block {
+        unsigned virtAddr;  ///< Address of the first instruction.
+        unsigned length;    ///< Number of instructions; 0 if the first one
+                            ///< cannot be translated.
+        unsigned words[MAX_BLOCK_LENGTH];  ///< Instructions as found in
+                                           ///< memory when translated.
+        BlockCode code;
+    };
+
+    /// Build the block of code at virtual address `virtAddr`, found at
+    /// physical address `physAddr`.
+    Block *Translate(unsigned virtAddr, unsigned physAddr);
+
+    /// Emit the host code for the `length` instructions in `instrs`.
+    BlockCode Emit(const Instruction *instrs, unsigned length,
+                   unsigned virtAddr);
+
+    /// Forget every block and start filling the arena again.
+    void Flush();
+
+    MMU *mmu;
+    int *registers;
+    DecodeCache *decodeCache;
+
+    /// Executable memory holding the generated code.
+    uint8_t *arena;
+    uint8_t *arenaFree;  ///< Start of the unused part of `arena`.
+
+    /// Blocks and entry counts, indexed by the physical address of their
+    /// first instruction.
+    Block **blocks;
+    unsigned char *counts;
+    unsigned numEntries;
+
+    /// Whether the previous call ran a whole block; the code right after a
+    /// block is looked up even if it is reached sequentially.
+    bool afterBlock;
+};
+
+#endif
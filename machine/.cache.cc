@@ -0,0 +1,118 @@
+/// DO NOT CHANGE -- part of the machine emulation
+///
+/// Copyright (c) 2016-2019 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#include ".cache.hh"
+#include "statistics.hh"
+#include "lib/utility.hh"
+
+#include <string.h>
+
+bool
+ParseReplacementPolicy(const char *name, ReplacementPolicy *policy) {
+    ASSERT(name);
+    ASSERT(policy);
+
+    if (!strcmp(name, "lru"))
+        *policy = LRU_REPLACEMENT;
+    else if (!strcmp(name, "fifo"))
+        *policy = FIFO_REPLACEMENT;
+    else if (!strcmp(name, "random"))
+        *policy = RANDOM_REPLACEMENT;
+    else
+        return false;
+    return true;
+}
+
+static inline bool
+IsPowerOfTwo(unsigned n) {
+    return n != 0 && (n & (n - 1)) == 0;
+}
+
+Cache::Cache(unsigned size, unsigned setWays, unsigned lineSize,
+             ReplacementPolicy replacement,
+             unsigned long long *accessCount, unsigned long long *missCount,
+             unsigned long long *writeBackCount) {
+    ASSERT(IsPowerOfTwo(size));
+    ASSERT(IsPowerOfTwo(setWays));
+    ASSERT(IsPowerOfTwo(lineSize) && lineSize >= 4);
+    ASSERT(size >= setWays * lineSize);
+    ASSERT(accessCount);
+    ASSERT(missCount);
+
+    ways    = setWays;
+    numSets = size / (ways * lineSize);
+    policy  = replacement;
+    for (lineShift = 0; 1U << lineShift < lineSize; lineShift++)
+        ;
+
+    lines = new Line [numSets * ways];
+    for (unsigned i = 0; i < numSets * ways; i++) {
+        lines[i].valid = false;
+        lines[i].dirty = false;
+    }
+
+    clock       = 0;
+    randomState = 1;
+    stallTicks  = 0;
+    accesses    = accessCount;
+    misses      = missCount;
+    writeBacks  = writeBackCount;
+}
+
+Cache::~Cache() {
+    delete [] lines;
+}
+
+/// Invalid lines are always used first.
+Cache::Line *
+Cache::Victim(Line *set) {
+    for (unsigned w = 0; w < ways; w++)
+        if (!set[w].valid) return &set[w];
+
+    if (policy == RANDOM_REPLACEMENT) {
+        // Xorshift.
+        randomState ^= randomState << 13;
+        randomState ^= randomState >> 17;
+        randomState ^= randomState << 5;
+        return &set[randomState % ways];
+    }
+
+    // Both LRU and FIFO replace the oldest stamp; they differ in whether a
+    // hit renews it.
+    Line *oldest = &set[0];
+    for (unsigned w = 1; w < ways; w++)
+        if (set[w].stamp < oldest->stamp) oldest = &set[w];
+    return oldest;
+}
+
+void
+Cache::Access(unsigned physAddr, bool writing) {
+    unsigned tag = physAddr >> lineShift;
+    Line *set = &lines[(tag & (numSets - 1)) * ways];
+
+    clock++;
+    (*accesses)++;
+    for (unsigned w = 0; w < ways; w++)
+        if (set[w].valid && set[w].tag == tag) {
+            if (policy == LRU_REPLACEMENT) set[w].stamp = clock;
+            if (writing) set[w].dirty = true;
+            return;
+        }
+
+    (*misses)++;
+    stallTicks += CACHE_MISS_TIME;
+
+    Line *line = Victim(set);
+    if (line->valid && line->dirty) {  // Write it back first.
+        ASSERT(writeBacks);
+        (*writeBacks)++;
+        stallTicks += CACHE_MISS_TIME;
+    }
+    line->tag   = tag;
+    line->valid = true;
+    line->dirty = writing;
+    line->stamp = clock;
+}
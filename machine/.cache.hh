@@ -0,0 +1,86 @@
+/// Model of a processor cache, for timing.
+///
+/// The simulated machine has no real cache: every access still goes
+/// straight to `mainMemory`.  A `Cache` only keeps the tags of the lines it
+/// would hold, to tell whether an access would hit, and charges the ticks a
+/// miss would cost.  Caches are physically indexed and tagged, write back
+/// and allocate on writes.
+///
+/// DO NOT CHANGE -- part of the machine emulation
+///
+/// Copyright (c) 2016-2019 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_MACHINE_CACHE__HH
+#define NACHOS_MACHINE_CACHE__HH
+
+/// Which line of a set is replaced on a miss, once all of them are valid.
+enum ReplacementPolicy {
+    LRU_REPLACEMENT,     ///< The least recently used.
+    FIFO_REPLACEMENT,    ///< The one filled first.
+    RANDOM_REPLACEMENT   ///< Any of them.
+};
+
+/// Return the policy named `name` (“lru”, “fifo” or “random”) into
+/// `policy`, or false if there is none by that name.
+bool ParseReplacementPolicy(const char *name, ReplacementPolicy *policy);
+
+class Cache {
+public:
+
+    /// Model a cache of `size` bytes, in lines of `lineSize` bytes, with
+    /// `ways` lines per set.  Sizes must be powers of two.
+    ///
+    /// The counters given are incremented on every access, miss and write
+    /// back of a dirty line (`writeBacks` may be null for a cache that is
+    /// never written).
+    Cache(unsigned size, unsigned ways, unsigned lineSize,
+          ReplacementPolicy policy, unsigned long long *accesses,
+          unsigned long long *misses, unsigned long long *writeBacks);
+
+    ~Cache();
+
+    /// Look up the line holding physical address `physAddr`, filling it on
+    /// a miss.
+    void Access(unsigned physAddr, bool writing);
+
+    /// Return the ticks that the accesses since the last call stalled for,
+    /// and start counting again.
+    unsigned TakeStallTicks() {
+        unsigned ticks = stallTicks;
+        stallTicks = 0;
+        return ticks;
+    }
+
+private:
+
+    struct Line {
+        unsigned tag;  ///< Physical address divided by the line size.
+        bool valid;
+        bool dirty;
+        unsigned long long stamp;  ///< When filled, or last used with LRU.
+    };
+
+    /// Pick the line of `set` to fill next.
+    Line *Victim(Line *set);
+
+    Line *lines;  ///< `ways` lines for every set, one set after the other.
+
+    unsigned numSets;
+    unsigned ways;
+    unsigned lineShift;  ///< Base 2 logarithm of the line size.
+    ReplacementPolicy policy;
+
+    unsigned long long clock;  ///< Counts accesses, to stamp lines.
+    unsigned randomState;  ///< Own generator, so that the delays drawn by
+                           ///< `Random` for the timer stay the same.
+
+    unsigned stallTicks;
+
+    unsigned long long *accesses;
+    unsigned long long *misses;
+    unsigned long long *writeBacks;
+};
+
+#endif
@@ -0,0 +1,169 @@
+/// Checkpoints of the simulated machine.
+///
+/// A checkpoint holds the CPU registers, the simulated time, the page
+/// table in use and the whole of physical memory, so that a user program
+/// can later go on from there without booting and loading it again.
+///
+/// The file starts with a `CheckpointHeader`, followed by the page table.
+/// Memory comes last, starting at a multiple of the page size of the host,
+/// so that restoring maps it straight from the file: pages are only read
+/// as the program touches them, and copied if it writes them.  Pages of
+/// memory that are all zeros are left as holes in the file.
+///
+/// DO NOT CHANGE -- part of the machine emulation
+///
+/// Copyright (c) 2016-2019 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#include "machine.hh"
+#include "threads/system.hh"
+
+#include <stdio.h>
+#include <string.h>
+
+/// Return whether the `size` bytes at `p` are all zero.
+static bool
+IsZero(const char *p, unsigned size) {
+    for (unsigned i = 0; i < size; i++)
+        if (p[i] != 0) return false;
+    return true;
+}
+
+static const unsigned CHECKPOINT_MAGIC   = 0x4E434B50;  // “NCKP”.
+static const unsigned CHECKPOINT_VERSION = 1;
+
+struct CheckpointHeader {
+    unsigned magic;
+    unsigned version;
+    unsigned numPhysPages;
+    unsigned pageSize;
+    unsigned pageTableSize;
+    unsigned memoryOffset;  ///< Where memory starts in the file.
+    unsigned long long totalTicks;
+    unsigned long long idleTicks;
+    unsigned long long systemTicks;
+    unsigned long long userTicks;
+    unsigned numPageFaults;
+    int registers[NUM_TOTAL_REGS];
+};
+
+/// Pending interrupts are not saved: their handlers belong to the devices
+/// of this run.  Whoever restores the checkpoint has its own devices, whose
+/// interrupts are moved to the time saved here.
+void
+Machine::SaveCheckpoint(const char *fileName) const {
+    ASSERT(fileName);
+
+    CheckpointHeader h;
+    memset(&h, 0, sizeof h);
+    h.magic         = CHECKPOINT_MAGIC;
+    h.version       = CHECKPOINT_VERSION;
+    h.numPhysPages  = mmu.GetNumPhysPages();
+    h.pageSize      = mmu.GetPageSize();
+    h.pageTableSize = mmu.pageTable ? mmu.pageTableSize : 0;
+    h.totalTicks    = stats->totalTicks;
+    h.idleTicks     = stats->idleTicks;
+    h.systemTicks   = stats->systemTicks;
+    h.userTicks     = stats->userTicks;
+    h.numPageFaults = stats->numPageFaults;
+    memcpy(h.registers, registers, sizeof h.registers);
+
+    unsigned tableBytes = h.pageTableSize * sizeof *mmu.pageTable;
+    unsigned hostPage   = HostPageSize();
+    h.memoryOffset = DivRoundUp((unsigned) sizeof h + tableBytes, hostPage)
+                       * hostPage;
+
+    int fd = OpenForWrite(fileName);
+    WriteFile(fd, (const char *) &h, sizeof h);
+    if (tableBytes > 0)
+        WriteFile(fd, (const char *) mmu.pageTable, tableBytes);
+    unsigned memorySize = mmu.GetMemorySize();
+    bool lastWritten = false;
+    for (unsigned i = 0; i < memorySize; i += hostPage) {
+        unsigned size = memorySize - i < hostPage ? memorySize - i : hostPage;
+        lastWritten = !IsZero(&mmu.mainMemory[i], size);
+        if (lastWritten) {
+            Lseek(fd, h.memoryOffset + i, SEEK_SET);
+            WriteFile(fd, &mmu.mainMemory[i], size);
+        }
+    }
+    if (!lastWritten) {  // Give the file its full length.
+        Lseek(fd, h.memoryOffset + memorySize - 1, SEEK_SET);
+        WriteFile(fd, "", 1);
+    }
+    Close(fd);
+
+    DEBUG('m', "Checkpoint saved into %s at time %llu.\n",
+          fileName, h.totalTicks);
+}
+
+/// The kernel takes ownership of the page table, which it must install
+/// before running the machine.
+bool
+Machine::RestoreCheckpoint(const char *fileName,
+                           TranslationEntry **pageTable,
+                           unsigned *pageTableSize) {
+    ASSERT(fileName);
+    ASSERT(pageTable);
+    ASSERT(pageTableSize);
+
+    int fd = OpenForReadWrite(fileName, false);
+    if (fd < 0) return false;
+
+    CheckpointHeader h;
+    if (ReadPartial(fd, (char *) &h, sizeof h) != (int) sizeof h
+          || h.magic != CHECKPOINT_MAGIC || h.version != CHECKPOINT_VERSION) {
+        printf("%s is not a checkpoint of this version of Nachos.\n",
+               fileName);
+        Close(fd);
+        return false;
+    }
+    if (h.numPhysPages != mmu.GetNumPhysPages()
+          || h.pageSize != mmu.GetPageSize()) {
+        printf("%s was saved with %u pages of %u bytes; use `-m` and `-ps` "
+               "to match.\n", fileName, h.numPhysPages, h.pageSize);
+        Close(fd);
+        return false;
+    }
+    Lseek(fd, 0, SEEK_END);
+    if ((unsigned) Tell(fd) < h.memoryOffset + mmu.GetMemorySize()) {
+        printf("%s is truncated.\n", fileName);
+        Close(fd);
+        return false;
+    }
+
+    *pageTableSize = h.pageTableSize;
+    *pageTable     = new TranslationEntry [h.pageTableSize];
+    if (h.pageTableSize > 0) {
+        Lseek(fd, sizeof h, SEEK_SET);
+        Read(fd, (char *) *pageTable,
+             h.pageTableSize * sizeof **pageTable);
+    }
+
+    // Fall back to reading memory if the host cannot map it.
+    if (!MapFileOver(mmu.mainMemory, mmu.GetMemorySize(), fd,
+                     h.memoryOffset)) {
+        Lseek(fd, h.memoryOffset, SEEK_SET);
+        Read(fd, mmu.mainMemory, mmu.GetMemorySize());
+    }
+    Close(fd);  // The mapping stays after closing.
+
+    memcpy(registers, h.registers, sizeof registers);
+    if (mmu.tlb)
+        for (unsigned i = 0; i < TLB_SIZE; i++) mmu.tlb[i].valid = false;
+    mmu.InvalidateTranslationCache();
+
+    // Move what this run has scheduled so far to the time saved.
+    interrupt->ShiftPending((long long) h.totalTicks
+                              - (long long) stats->totalTicks);
+    stats->totalTicks    = h.totalTicks;
+    stats->idleTicks     = h.idleTicks;
+    stats->systemTicks   = h.systemTicks;
+    stats->userTicks     = h.userTicks;
+    stats->numPageFaults = h.numPageFaults;
+
+    DEBUG('m', "Checkpoint restored from %s at time %llu.\n",
+          fileName, h.totalTicks);
+    return true;
+}
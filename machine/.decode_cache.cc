@@ -0,0 +1,24 @@
+/// DO NOT CHANGE -- part of the machine emulation
+///
+/// Copyright (c) 2016-2019 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#include ".decode_cache.hh"
+#include "lib/utility.hh"
+
+/// The entries are only given host memory as they get used, so a large
+/// physical memory does not make starting up slower.
+///
+/// * `memorySize` is the size of physical memory, in bytes.
+DecodeCache::DecodeCache(unsigned memorySize) {
+    ASSERT(memorySize % 4 == 0);
+
+    numEntries = memorySize / 4;
+    entries    = (Instruction *) AllocZeroedArray(numEntries
+                                                  * sizeof *entries);
+}
+
+DecodeCache::~DecodeCache() {
+    DeallocZeroedArray((char *) entries, numEntries * sizeof *entries);
+}
@@ -0,0 +1,59 @@
+/// Cache of already decoded user instructions.
+///
+/// Decoding a MIPS instruction is pure: the same binary word always yields
+/// the same `Instruction` record.  So instead of calling
+/// `Instruction::Decode` on every fetch, the simulator keeps one decoded
+/// record per word of physical memory, tagged with the binary word it was
+/// decoded from.  A fetch only decodes again when the word in memory no
+/// longer matches the tag.
+///
+/// Tagging with the raw word (instead of tracking writes) keeps the cache
+/// coherent no matter how memory gets modified: user stores through
+/// `MMU::WriteMem`, as well as the kernel writing straight into
+/// `mainMemory` when loading a program or paging in a frame.
+///
+/// DO NOT CHANGE -- part of the machine emulation
+///
+/// Copyright (c) 2016-2019 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_MACHINE_DECODECACHE__HH
+#define NACHOS_MACHINE_DECODECACHE__HH
+
+#include ".instruction.hh"
+
+class DecodeCache {
+public:
+
+    /// Create a cache covering `memorySize` bytes of physical memory.
+    DecodeCache(unsigned memorySize);
+
+    ~DecodeCache();
+
+    /// Return the decoded form of `raw`, the instruction word stored at
+    /// physical address `physAddr`.
+    ///
+    /// Only decodes when the cached record was built from a different
+    /// word, or was never built at all.
+    const Instruction *Lookup(unsigned physAddr, unsigned raw) {
+        Instruction *instr = &entries[physAddr / 4];
+        if (instr->value != raw || instr->opCode == 0) {
+            instr->value = raw;
+            instr->Decode();
+        }
+        return instr;
+    }
+
+private:
+
+    /// One decoded record per word of physical memory.
+    ///
+    /// Records start zero-filled; since no operation is numbered 0, a null
+    /// `opCode` tells that the record has not been decoded yet.
+    Instruction *entries;
+
+    unsigned numEntries;
+};
+
+#endif
@@ -9,6 +9,10 @@
 /// Simulated machine byte ordering
 ///     Main memory.
 ///
+/// The conversions are done on every access to simulated memory, so they
+/// are inline, and the byte order of the host is decided when Nachos is
+/// built: *HOST_IS_BIG_ENDIAN* must be defined on big endian hosts.
+///
 /// Copyright (c) 1992-1993 The Regents of the University of California.
 ///               2016-2018 Docentes de la Universidad Nacional de Rosario.
 /// All rights reserved.  See `copyright.h` for copyright notice and
@@ -19,10 +23,36 @@
 
 #include ".bin/noff.h"
 
-unsigned WordToHost(unsigned word);
-unsigned short ShortToHost(unsigned short shortword);
-unsigned WordToMachine(unsigned word);
-unsigned short ShortToMachine(unsigned short shortword);
+inline unsigned
+WordToHost(unsigned word) {
+#ifdef HOST_IS_BIG_ENDIAN
+    return (word >> 24 & 0x000000FF) | (word >>  8 & 0x0000FF00)
+         | (word <<  8 & 0x00FF0000) | (word << 24 & 0xFF000000);
+#else
+    return word;
+#endif
+}
+
+inline unsigned short
+ShortToHost(unsigned short shortword) {
+#ifdef HOST_IS_BIG_ENDIAN
+    return (unsigned short) ((shortword << 8 & 0xFF00)
+                             | (shortword >> 8 & 0x00FF));
+#else
+    return shortword;
+#endif
+}
+
+inline unsigned
+WordToMachine(unsigned word) {
+    return WordToHost(word);
+}
+
+inline unsigned short
+ShortToMachine(unsigned short shortword) {
+    return ShortToHost(shortword);
+}
+
 void SwapHeader(noffHeader* noffH);
 
 #endif
@@ -0,0 +1,101 @@
+/// DO NOT CHANGE -- part of the machine emulation
+///
+/// Copyright (c) 2016-2019 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#include ".event_log.hh"
+#include "threads/system.hh"
+
+#include <string.h>
+
+/// When replaying, the whole log is read at once, and split by source.
+EventLog::EventLog(const char *fileName, bool replay) {
+    ASSERT(fileName);
+
+    replaying = replay;
+    if (!replaying) {
+        file = fopen(fileName, "wb");
+        ASSERT(file);
+        return;
+    }
+
+    file = nullptr;
+    FILE *f = fopen(fileName, "rb");
+    ASSERT(f);
+
+    LogRecord r;
+    while (fread(&r, sizeof r, 1, f) == 1) {
+        ASSERT(r.source < NUM_EVENT_SOURCES);
+
+        Event *e = new Event;
+        e->ticks = r.ticks;
+        e->size  = r.size;
+        e->data  = new char [r.size];
+        size_t got = fread(e->data, 1, r.size, f);
+        ASSERT(got == r.size);
+        events[r.source].Append(e);
+    }
+    fclose(f);
+}
+
+EventLog::~EventLog() {
+    if (file) fclose(file);
+
+    for (unsigned s = 0; s < NUM_EVENT_SOURCES; s++)
+        while (!events[s].IsEmpty()) {
+            Event *e = events[s].Pop();
+            delete [] e->data;
+            delete e;
+        }
+}
+
+bool
+EventLog::IsReplaying() const {
+    return replaying;
+}
+
+void
+EventLog::Record(EventSource source, const void *data, unsigned size) {
+    ASSERT(!replaying);
+    ASSERT(data);
+
+    LogRecord r;
+    r.ticks  = stats->totalTicks;
+    r.source = source;
+    r.size   = size;
+    fwrite(&r, sizeof r, 1, file);
+    fwrite(data, 1, size, file);
+}
+
+void
+EventLog::Take(EventSource source, void *data, unsigned size) {
+    Event *e = events[source].Pop();
+    ASSERT(e->size == size);  // Else the log is from another Nachos.
+
+    memcpy(data, e->data, size);
+    delete [] e->data;
+    delete e;
+}
+
+bool
+EventLog::Replay(EventSource source, void *data, unsigned size) {
+    ASSERT(replaying);
+    ASSERT(data);
+
+    if (events[source].IsEmpty()) return false;
+    Take(source, data, size);
+    return true;
+}
+
+bool
+EventLog::ReplayDue(EventSource source, void *data, unsigned size) {
+    ASSERT(replaying);
+    ASSERT(data);
+
+    if (events[source].IsEmpty()
+          || events[source].Head()->ticks > stats->totalTicks)
+        return false;
+    Take(source, data, size);
+    return true;
+}
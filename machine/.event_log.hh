@@ -0,0 +1,89 @@
+/// Log of the events that come from outside of the simulation.
+///
+/// Console input, network packets and the random delays of the timer
+/// differ from one run to the next, which makes two runs (or two builds of
+/// Nachos) hard to compare.  When recording, the devices write each of
+/// those events, with the tick it happened at, into a log file; when
+/// replaying, they take them from the log instead of the host.
+///
+/// Input and packets are delivered by the same polling interrupts as
+/// usual, the first time they poll at or after the tick recorded, so the
+/// workload stays the same even if the build being replayed runs the
+/// kernel faster or slower.  Random delays are taken in the order they
+/// were recorded.
+///
+/// The log is a sequence of records, each made of a `LogRecord` followed
+/// by `size` bytes of data.
+///
+/// DO NOT CHANGE -- part of the machine emulation
+///
+/// Copyright (c) 2016-2019 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_MACHINE_EVENTLOG__HH
+#define NACHOS_MACHINE_EVENTLOG__HH
+
+#include "lib/list.hh"
+
+#include <stdio.h>
+
+/// Where an event comes from.
+enum EventSource {
+    TIMER_EVENT,    ///< A random delay of the timer.
+    CONSOLE_EVENT,  ///< A character typed at the console.
+    PACKET_EVENT,   ///< A packet arriving from the network.
+    LOSS_EVENT,     ///< Whether a packet sent was lost.
+    NUM_EVENT_SOURCES
+};
+
+class EventLog {
+public:
+
+    /// Start recording events into the file `fileName`, or, if `replay`
+    /// is true, replaying the events recorded in it.
+    EventLog(const char *fileName, bool replay);
+
+    /// Finish writing the log, if recording.
+    ~EventLog();
+
+    bool IsReplaying() const;
+
+    /// Record that `source` produced the `size` bytes at `data` now.
+    void Record(EventSource source, const void *data, unsigned size);
+
+    /// Take the next event of `source`, copying its data into the `size`
+    /// bytes at `data`.
+    ///
+    /// Return false if there are no more.
+    bool Replay(EventSource source, void *data, unsigned size);
+
+    /// Like `Replay`, but only take the next event if it was recorded no
+    /// later than now.
+    bool ReplayDue(EventSource source, void *data, unsigned size);
+
+private:
+
+    struct LogRecord {
+        unsigned long long ticks;
+        unsigned source;
+        unsigned size;
+    };
+
+    struct Event {
+        unsigned long long ticks;
+        unsigned size;
+        char *data;
+    };
+
+    /// Copy the data of the first event in `events[source]` and drop it.
+    void Take(EventSource source, void *data, unsigned size);
+
+    bool replaying;
+
+    FILE *file;  ///< The log being recorded; null when replaying.
+
+    List<Event *> events[NUM_EVENT_SOURCES];  ///< Events left to replay.
+};
+
+#endif
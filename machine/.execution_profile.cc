@@ -0,0 +1,227 @@
+/// DO NOT CHANGE -- part of the machine emulation
+///
+/// Copyright (c) 2016-2019 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#include ".execution_profile.hh"
+#include "machine.hh"
+
+#include <stdio.h>
+#include <string.h>
+
+/// Return a copy of the `size` entries of `array` with room for at least
+/// `index + 1` entries, the new ones zeroed, and update `size`.
+template <class T>
+static T *
+Enlarge(T *array, unsigned *size, unsigned index) {
+    ASSERT(size);
+
+    unsigned newSize = *size > 0 ? *size : 64;
+    while (newSize <= index) newSize *= 2;
+
+    T *bigger = new T [newSize];
+    memset(bigger, 0, newSize * sizeof *bigger);
+    if (array) memcpy(bigger, array, *size * sizeof *array);
+    delete [] array;
+
+    *size = newSize;
+    return bigger;
+}
+
+/// Return the index of the largest of the `size` numbers in `keys`, and
+/// zero it so that it is not taken again; return `size` if all of them are
+/// zero.
+static unsigned
+TakeLargest(unsigned long long *keys, unsigned size) {
+    ASSERT(keys);
+
+    unsigned best = size;
+    for (unsigned i = 0; i < size; i++)
+        if (keys[i] != 0 && (best == size || keys[i] > keys[best]))
+            best = i;
+    if (best < size) keys[best] = 0;
+    return best;
+}
+
+ExecutionProfile::ExecutionProfile(unsigned pageSize, const char *symbolFile)
+  : symbols(symbolFile) {
+    ASSERT(pageSize > 0 && (pageSize & (pageSize - 1)) == 0);
+
+    code     = nullptr;
+    codeSize = 0;
+    pages    = nullptr;
+    numPages = 0;
+    for (pageShift = 0; 1U << pageShift < pageSize; pageShift++);
+
+    total  = 0;
+    reads  = 0;
+    writes = 0;
+
+    blockStart     = 0;
+    lastPc         = 0;
+    lastSequential = false;
+}
+
+ExecutionProfile::~ExecutionProfile() {
+    delete [] code;
+    delete [] pages;
+}
+
+ExecutionProfile::Code *
+ExecutionProfile::CodeAt(unsigned pc) {
+    if (pc / 4 >= codeSize) code = Enlarge(code, &codeSize, pc / 4);
+    return &code[pc / 4];
+}
+
+ExecutionProfile::Page *
+ExecutionProfile::PageAt(unsigned vpn) {
+    if (vpn >= MAX_PAGES) return nullptr;
+    if (vpn >= numPages) pages = Enlarge(pages, &numPages, vpn);
+    return &pages[vpn];
+}
+
+void
+ExecutionProfile::Record(const int *registers, const Instruction *instr) {
+    ASSERT(registers);
+    ASSERT(instr);
+
+    unsigned pc = registers[PC_REG];
+    if (!lastSequential || pc != lastPc + 4) {
+        blockStart = pc;  // Jumped here, or came from a delay slot.
+        CodeAt(pc)->entries++;
+    }
+    Code *c = CodeAt(pc);
+    c->executed++;
+    c->opCode = instr->opCode;
+    CodeAt(blockStart)->blockLength++;
+
+    lastPc = pc;
+    lastSequential = (unsigned) registers[NEXT_PC_REG] == pc + 4;
+    total++;
+
+    unsigned addr = registers[instr->rs] + instr->extra;
+    Page *p;
+    switch (instr->opCode) {
+        case OP_LB:
+        case OP_LBU:
+        case OP_LH:
+        case OP_LHU:
+        case OP_LW:
+        case OP_LWL:
+        case OP_LWR:
+            if ((p = PageAt(addr >> pageShift)) != nullptr) p->reads++;
+            reads++;
+            break;
+
+        case OP_SB:
+        case OP_SH:
+        case OP_SW:
+        case OP_SWL:
+        case OP_SWR:
+            if ((p = PageAt(addr >> pageShift)) != nullptr) p->writes++;
+            writes++;
+            break;
+    }
+}
+
+void
+ExecutionProfile::PrintInstructions() const {
+    printf("Instructions:\n");
+
+    unsigned long long *keys = new unsigned long long [codeSize];
+    for (unsigned i = 0; i < codeSize; i++) keys[i] = code[i].executed;
+
+    for (unsigned rank = 1; rank <= SHOWN; rank++) {
+        unsigned i = TakeLargest(keys, codeSize);
+        if (i == codeSize) break;
+
+        const char *op = OP_STRINGS[code[i].opCode].string;
+        printf("%4u. %12llu %6.2f%%  %-8.*s  ", rank, code[i].executed,
+               100.0 * code[i].executed / total, (int) strcspn(op, " "), op);
+        symbols.PrintAddress(i * 4);
+        printf("\n");
+    }
+
+    delete [] keys;
+}
+
+/// Instructions before the first symbol are counted as part of an unnamed
+/// function.
+void
+ExecutionProfile::PrintFunctions() const {
+    unsigned numSymbols = symbols.Length();
+    if (numSymbols == 0) return;
+    printf("Functions:\n");
+
+    unsigned long long *counts = new unsigned long long [numSymbols + 1];
+    unsigned long long *keys   = new unsigned long long [numSymbols + 1];
+    memset(counts, 0, (numSymbols + 1) * sizeof *counts);
+    for (unsigned i = 0; i < codeSize; i++)
+        counts[symbols.Find(i * 4)] += code[i].executed;
+    memcpy(keys, counts, (numSymbols + 1) * sizeof *keys);
+
+    for (unsigned rank = 1; rank <= SHOWN; rank++) {
+        unsigned s = TakeLargest(keys, numSymbols + 1);
+        if (s == numSymbols + 1) break;
+
+        printf("%4u. %12llu %6.2f%%  %s\n", rank, counts[s],
+               100.0 * counts[s] / total,
+               s < numSymbols ? symbols.GetName(s) : "(unknown)");
+    }
+
+    delete [] counts;
+    delete [] keys;
+}
+
+void
+ExecutionProfile::PrintBlocks() const {
+    printf("Basic blocks:\n");
+
+    unsigned long long *keys = new unsigned long long [codeSize];
+    for (unsigned i = 0; i < codeSize; i++) keys[i] = code[i].blockLength;
+
+    for (unsigned rank = 1; rank <= SHOWN; rank++) {
+        unsigned i = TakeLargest(keys, codeSize);
+        if (i == codeSize) break;
+
+        printf("%4u. %12llu %6.2f%%  entered %llu times, %.1f long  ",
+               rank, code[i].blockLength, 100.0 * code[i].blockLength / total,
+               code[i].entries, (double) code[i].blockLength / code[i].entries);
+        symbols.PrintAddress(i * 4);
+        printf("\n");
+    }
+
+    delete [] keys;
+}
+
+void
+ExecutionProfile::PrintPages() const {
+    printf("Data pages, %llu reads and %llu writes:\n", reads, writes);
+
+    unsigned long long *keys = new unsigned long long [numPages];
+    for (unsigned i = 0; i < numPages; i++)
+        keys[i] = pages[i].reads + pages[i].writes;
+
+    for (unsigned rank = 1; rank <= SHOWN; rank++) {
+        unsigned vpn = TakeLargest(keys, numPages);
+        if (vpn == numPages) break;
+
+        printf("%4u. %12llu reads %12llu writes  page %u (0x%08X)\n",
+               rank, pages[vpn].reads, pages[vpn].writes, vpn,
+               vpn << pageShift);
+    }
+
+    delete [] keys;
+}
+
+void
+ExecutionProfile::Print() const {
+    printf("Execution profile, out of %llu instructions:\n", total);
+    if (total == 0) return;
+
+    PrintInstructions();
+    PrintFunctions();
+    PrintBlocks();
+    PrintPages();
+}
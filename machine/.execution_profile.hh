@@ -0,0 +1,99 @@
+/// Profile of the execution of user programs.
+///
+/// Counts how many times each instruction is run, how many times each
+/// basic block is entered and how many instructions are run inside it, and
+/// how many data reads and writes go to each page.  The ranking printed
+/// when Nachos halts names the code by the function it belongs to, as
+/// found in the COFF file the program was built from (cf. `SymbolTable`).
+///
+/// Counts are kept by virtual address, so when several programs run at
+/// once, their counts are added together.  A basic block here is a run of
+/// instructions entered by a jump (or an exception) and left by the next
+/// one; an instruction that raises an exception is counted again when it
+/// is restarted.
+///
+/// DO NOT CHANGE -- part of the machine emulation
+///
+/// Copyright (c) 2016-2019 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_MACHINE_EXECUTIONPROFILE__HH
+#define NACHOS_MACHINE_EXECUTIONPROFILE__HH
+
+#include ".instruction.hh"
+#include ".symbol_table.hh"
+
+class ExecutionProfile {
+public:
+
+    /// Create an empty profile, for pages of `pageSize` bytes.
+    ///
+    /// Addresses are named after the symbols in the COFF file
+    /// `symbolFile`; if it is null, or cannot be read, they are only
+    /// printed in hexadecimal.
+    ExecutionProfile(unsigned pageSize, const char *symbolFile);
+
+    ~ExecutionProfile();
+
+    /// Count the instruction `instr`, about to be run with the CPU
+    /// registers `registers`.
+    void Record(const int *registers, const Instruction *instr);
+
+    /// Print the hottest instructions, functions, blocks and pages.
+    void Print() const;
+
+private:
+
+    /// Number of entries shown in each ranking.
+    static const unsigned SHOWN = 20;
+
+    static const unsigned MAX_PAGES = 1 << 16;
+
+    struct Code {
+        unsigned long long executed;     ///< Times the instruction ran.
+        unsigned long long entries;      ///< Times a block started here.
+        unsigned long long blockLength;  ///< Instructions run in blocks
+                                         ///< starting here.
+        unsigned char opCode;
+    };
+
+    struct Page {
+        unsigned long long reads;
+        unsigned long long writes;
+    };
+
+    /// Return the counters of the instruction at `pc`, making room for
+    /// them if needed.
+    Code *CodeAt(unsigned pc);
+
+    /// Return the counters of virtual page `vpn`, making room for them if
+    /// needed.  Only the first `MAX_PAGES` pages are counted: any access
+    /// beyond them is bound to fail.
+    Page *PageAt(unsigned vpn);
+
+    void PrintInstructions() const;
+    void PrintFunctions() const;
+    void PrintBlocks() const;
+    void PrintPages() const;
+
+    Code *code;  ///< Indexed by address / 4.
+    unsigned codeSize;
+
+    Page *pages;  ///< Indexed by virtual page number.
+    unsigned numPages;
+    unsigned pageShift;
+
+    SymbolTable symbols;
+
+    unsigned long long total;  ///< Instructions recorded.
+    unsigned long long reads;
+    unsigned long long writes;
+
+    unsigned blockStart;  ///< Address of the block being run.
+    unsigned lastPc;
+    bool lastSequential;  ///< Whether the last instruction was followed by
+                          ///< the next one in memory.
+};
+
+#endif
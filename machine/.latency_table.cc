@@ -0,0 +1,132 @@
+/// DO NOT CHANGE -- part of the machine emulation
+///
+/// Copyright (c) 2016-2019 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#include ".latency_table.hh"
+#include "lib/utility.hh"
+
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+/// The presets only make multiplications and divisions longer; the figures
+/// are those of the manuals, rounded.  The R3000 interlocks on a load used
+/// right away, and the longer pipeline of the R4000 also loses cycles on
+/// every branch taken.
+static const struct {
+    const char *name;
+    unsigned multiply;
+    unsigned divide;
+    unsigned loadUse;
+    unsigned branch;
+} PRESETS[] = {
+    { "unit",   1,  1, 0, 0 },
+    { "r3000", 12, 35, 1, 0 },
+    { "r4000", 10, 69, 2, 2 },
+};
+
+static bool
+IsStore(unsigned op) {
+    return op == OP_SB || op == OP_SH || op == OP_SW
+           || op == OP_SWL || op == OP_SWR;
+}
+
+/// The registers read by an opcode are found from how it is printed: the
+/// first register printed is the one written, except for stores, branches
+/// and the like, whose first register is `rs`, or is `rt` being stored.
+/// `LWL` and `LWR` merge the word loaded into `rt`, so they read it too.
+LatencyTable::LatencyTable() {
+    for (unsigned op = 0; op <= MAX_OPCODE; op++) {
+        readsRs[op] = readsRt[op] = false;
+        for (unsigned i = 0; i < 3; i++) {
+            RegType type = OP_STRINGS[op].args[i];
+            if (type == RS)
+                readsRs[op] = true;
+            else if (type == RT && (i > 0 || IsStore(op)
+                                      || op == OP_LWL || op == OP_LWR))
+                readsRt[op] = true;
+        }
+    }
+    Reset();
+}
+
+void
+LatencyTable::Reset() {
+    for (unsigned op = 0; op <= MAX_OPCODE; op++) extra[op] = 0;
+    loadUsePenalty = 0;
+    branchPenalty  = 0;
+}
+
+bool
+LatencyTable::UsePreset(const char *name) {
+    ASSERT(name);
+
+    for (unsigned i = 0; i < sizeof PRESETS / sizeof *PRESETS; i++) {
+        if (strcmp(PRESETS[i].name, name) != 0) continue;
+
+        Reset();
+        extra[OP_MULT] = extra[OP_MULTU] = PRESETS[i].multiply - 1;
+        extra[OP_DIV]  = extra[OP_DIVU]  = PRESETS[i].divide - 1;
+        loadUsePenalty = PRESETS[i].loadUse;
+        branchPenalty  = PRESETS[i].branch;
+        return true;
+    }
+    return false;
+}
+
+/// Opcodes are named by the first word printed for them.
+bool
+LatencyTable::SetCost(const char *name, unsigned ticks) {
+    ASSERT(name);
+    ASSERT(ticks > 0);
+
+    size_t length = strlen(name);
+    for (unsigned op = 1; op < OP_UNIMP; op++) {
+        const char *s = OP_STRINGS[op].string;
+        if (strncasecmp(s, name, length) == 0
+              && (s[length] == ' ' || s[length] == '\0')) {
+            extra[op] = ticks - 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+/// Lines that cannot be understood are reported and skipped.
+bool
+LatencyTable::Load(const char *fileName) {
+    ASSERT(fileName);
+
+    FILE *f = fopen(fileName, "r");
+    if (f == nullptr) {
+        fprintf(stderr, "Could not open latency table `%s`.\n", fileName);
+        return false;
+    }
+
+    Reset();
+    char line[128];
+    for (unsigned n = 1; fgets(line, sizeof line, f); n++) {
+        char *comment = strchr(line, '#');
+        if (comment) *comment = '\0';
+
+        char name[32];
+        unsigned ticks;
+        int fields = sscanf(line, "%31s %u", name, &ticks);
+        if (fields <= 0) continue;  // Blank line.
+
+        bool ok = fields == 2;
+        if (ok && !strcmp(name, "load-use"))
+            loadUsePenalty = ticks;
+        else if (ok && !strcmp(name, "branch"))
+            branchPenalty = ticks;
+        else
+            ok = ok && ticks > 0 && SetCost(name, ticks);
+        if (!ok)
+            fprintf(stderr, "%s:%u: expected an opcode, `load-use` or "
+                    "`branch`, and a number of ticks.\n", fileName, n);
+    }
+    fclose(f);
+    return true;
+}
@@ -0,0 +1,79 @@
+/// Costs of user instructions, for timing.
+///
+/// Without a table, every user instruction takes `USER_TICK`.  A table
+/// makes some instructions take longer, to get closer to the timing of a
+/// real in-order MIPS core:
+/// * every opcode has its own cost, such as many ticks for a division;
+/// * an instruction that uses the register loaded by the instruction right
+///   before it stalls for the load-use penalty;
+/// * the first instruction after a branch or jump that was taken stalls
+///   for the branch penalty.
+///
+/// Tables come from a built-in preset or from a file.  Each line of a file
+/// holds either an opcode name (as printed by the `M` debug flag, such as
+/// `DIV`) and its cost in ticks, or `load-use` or `branch` and the ticks of
+/// that penalty.  Opcodes not listed cost one tick; `#` starts a comment.
+///
+/// DO NOT CHANGE -- part of the machine emulation
+///
+/// Copyright (c) 2016-2019 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_MACHINE_LATENCYTABLE__HH
+#define NACHOS_MACHINE_LATENCYTABLE__HH
+
+#include ".instruction.hh"
+
+class LatencyTable {
+public:
+
+    /// Start with every instruction costing one tick, and no penalties.
+    LatencyTable();
+
+    /// Take the costs of the preset `name`: `unit` (the default), `r3000`
+    /// or `r4000`.
+    ///
+    /// Return false, having changed nothing, if there is no such preset.
+    bool UsePreset(const char *name);
+
+    /// Take the costs listed in the file `fileName`.
+    ///
+    /// Return false, after telling why, if the file cannot be read.
+    bool Load(const char *fileName);
+
+    /// Return how many ticks `instr` takes on top of the first one.
+    ///
+    /// * `loadReg` is the register the previous instruction loaded, or 0.
+    /// * `branched` tells whether the previous instruction (a delay slot)
+    ///   was followed by the target of a branch or jump instead of the
+    ///   next instruction.
+    unsigned ExtraTicks(const Instruction *instr, unsigned loadReg,
+                        bool branched) const {
+        unsigned ticks = extra[instr->opCode];
+        if (loadReg != 0 && ((readsRs[instr->opCode] && instr->rs == loadReg)
+                               || (readsRt[instr->opCode]
+                                     && instr->rt == loadReg)))
+            ticks += loadUsePenalty;
+        if (branched) ticks += branchPenalty;
+        return ticks;
+    }
+
+private:
+
+    /// Make every instruction cost one tick, with no penalties.
+    void Reset();
+
+    /// Set the cost of the opcode named `name`; false if there is none.
+    bool SetCost(const char *name, unsigned ticks);
+
+    unsigned extra[MAX_OPCODE + 1];  ///< Cost of each opcode, minus one.
+
+    bool readsRs[MAX_OPCODE + 1];  ///< Which registers each opcode reads,
+    bool readsRt[MAX_OPCODE + 1];  ///< for the load-use penalty.
+
+    unsigned loadUsePenalty;
+    unsigned branchPenalty;
+};
+
+#endif
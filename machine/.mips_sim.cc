@@ -10,6 +10,8 @@
 /// All rights reserved.  See `copyright.h` for copyright notice and
 /// limitation of liability and disclaimer of warranty provisions.
 
+#include ".arithmetic.hh"
+#include ".endianness.hh"
 #include ".instruction.hh"
 #include "machine.hh"
 #include "threads/system.hh"
@@ -24,16 +26,69 @@ void
 Machine::Run() {
     Instruction *instr = new Instruction; // Storage for decoded instruction.
 
-    if (debug.IsEnabled('m')) printf("Starting to run at time %u.\n", stats->totalTicks);
+    if (debug.IsEnabled('m')) printf("Starting to run at time %llu.\n", stats->totalTicks);
     interrupt->SetStatus(USER_MODE);
 
     for (;;) {
-        if (FetchInstruction(instr)) ExecInstruction(instr);
-        interrupt->OneTick();
+#ifdef BINARY_TRANSLATION
+        if (translator && !singleStepper && translator->Execute())
+            ;  // A whole translated block ran; tick its last instruction.
+        else
+#endif
+        if (FetchInstruction(instr) && !(fuseSequences && ExecFused(instr)))
+            ExecInstruction(instr);
+        Tick();
         if (singleStepper && !singleStepper->Step()) singleStepper = nullptr;
     }
 }
 
+/// Advance the clock by one user instruction.
+///
+/// `Interrupt::OneTick` pops and re-inserts the first pending interrupt
+/// every time, just to find out it is not due yet.  Instead, the ticks
+/// before the next interrupt (as told by `Interrupt::NextDue`) only update
+/// the counters, and `OneTick` runs for the tick on which it falls due.  As
+/// the horizon is checked again after every instruction, an interrupt
+/// scheduled meanwhile by the kernel, or a pending yield, is still
+/// serviced on exactly the same tick.
+void
+Machine::Tick() {
+    if (modelStalls) Stall();
+
+    if (batchTicks && !interrupt->IsYieldPending()
+          && stats->totalTicks + USER_TICK < interrupt->NextDue())
+        interrupt->AdvanceUserTicks(1);
+    else
+        interrupt->OneTick();
+}
+
+/// Stall ticks are user ticks like any other, so they also use up the time
+/// slice of the thread, and are batched the same way as in `Tick`.  An
+/// interrupt may switch to another thread halfway, which is why the ticks
+/// left are kept in a local variable.
+void
+Machine::Stall() {
+    unsigned ticks = stallTicks;
+    stallTicks = 0;
+    if (instructionCache) ticks += instructionCache->TakeStallTicks();
+    if (dataCache) ticks += dataCache->TakeStallTicks();
+
+    while (ticks > 0) {
+        unsigned long long due = interrupt->NextDue();
+        if (batchTicks && !interrupt->IsYieldPending()
+              && stats->totalTicks + USER_TICK < due) {
+            unsigned long long room = (due - stats->totalTicks - 1)
+                                        / USER_TICK;
+            unsigned n = room < ticks ? (unsigned) room : ticks;
+            interrupt->AdvanceUserTicks(n);
+            ticks -= n;
+        } else {
+            interrupt->OneTick();
+            ticks--;
+        }
+    }
+}
+
 /// Simulate effects of a delayed load.
 ///
 /// NOTE -- `RaiseException`/`CheckInterrupts` must also call `DelayedLoad`,
@@ -46,14 +101,37 @@ Machine::DelayedLoad(unsigned nextReg, int nextValue) {
     registers[0] = 0;  // And always make sure R0 stays zero.
 }
 
+/// Fetch the instruction at the program counter.
+///
+/// The instruction is translated like any other read, but the decoding is
+/// taken from `decodeCache` whenever the word in memory has already been
+/// decoded before.
 bool
 Machine::FetchInstruction(Instruction *instr) {
     ASSERT(instr);
 
-    int raw;
-    if (!ReadMem(registers[PC_REG], 4, &raw)) return false;  // Exception occurred.
-    instr->value = raw;
-    instr->Decode();
+    unsigned physAddr;
+    ExceptionType e = mmu.Translate(registers[PC_REG], &physAddr, 4, false);
+    if (e != NO_EXCEPTION) {
+        RaiseException(e, registers[PC_REG]);
+        return false;
+    }
+
+    if (instructionCache) instructionCache->Access(physAddr, false);
+
+    unsigned raw = WordToHost(*(unsigned *) &mmu.mainMemory[physAddr]);
+    *instr = *decodeCache.Lookup(physAddr, raw);
+    fetchedAddr = physAddr;
+    TRACE(TRACE_FETCH, registers[PC_REG], raw, 0);
+
+    if (latencies) {
+        // Charged once, even if the instruction is retried after a fault.
+        stallTicks += latencies->ExtraTicks(instr, registers[LOAD_REG],
+                                            branched);
+        branched = false;
+    }
+
+    if (profiling) CountInstruction(instr);
 
     if (debug.IsEnabled('m')) {
         const struct OpString *str = &OP_STRINGS[instr->opCode];
@@ -69,71 +147,42 @@ Machine::FetchInstruction(Instruction *instr) {
     return true;
 }
 
-/// Simulate R2000 multiplication.
-///
-/// The words at `*hiPtr` and `*loPtr` are overwritten with the double-length
-/// result of the multiplication.
-static void
-Mult(int a, int b, bool signedArith, int *hiPtr, int *loPtr) {
-    ASSERT(hiPtr);
-    ASSERT(loPtr);
-
-    if (a == 0 || b == 0) {
-        *hiPtr = *loPtr = 0;
-        return;
-    }
-
-    // Compute the sign of the result, then make everything positive so
-    // unsigned computation can be done in the main loop.
-    bool negative = false;
-    if (signedArith) {
-        if (a < 0) {
-            negative = !negative;
-            a = -a;
-        }
-
-        if (b < 0) {
-            negative = !negative;
-            b = -b;
-        }
-    }
-
-    // Compute the result in unsigned arithmetic (check `a`'s bits one at a
-    // time, and add in a shifted value of `b`).
-    unsigned bLo = b;
-    unsigned bHi = 0;
-    unsigned lo = 0;
-    unsigned hi = 0;
-
-    for (unsigned i = 0; i < 32; i++) {
-        if (a & 1) {
-            lo += bLo;
-            if (lo < bLo)  // Carry out of the low bits?
-                hi += 1;
-            hi += bHi;
-            if ((a & 0xFFFFFFFE) == 0) break;
-        }
-
-        bHi <<= 1;
-        if (bLo & 0x80000000) bHi |= 1;
-
-        bLo <<= 1;
-        a >>= 1;
-    }
-
-    // If the result is supposed to be negative, compute the two's complement
-    // of the double-word result.
-    if (negative) {
-        hi = ~hi;
-        lo = ~lo;
-        lo++;
-        if (lo == 0) hi++;
-    }
-
-    *hiPtr = (int) hi;
-    *loPtr = (int) lo;
+/// Only called while profiling, so that the profiles cost a single test per
+/// instruction when they are not used.
+void
+Machine::CountInstruction(const Instruction *instr) {
+    if (sequenceProfile)
+        sequenceProfile->Record(registers[PC_REG], registers[NEXT_PC_REG],
+                                instr->opCode);
+    if (executionProfile) executionProfile->Record(registers, instr);
 }
 
+/// Instruction dispatch.
+///
+/// The body of every instruction is written once, and can be reached in two
+/// ways, selected at build time:
+///
+/// * by default, through a `switch` on the decoded opcode;
+/// * with *THREADED_CODE* defined (GCC only), through a table holding the
+///   address of each handler (computed `goto`), which avoids the range check
+///   of the `switch` and lets `ExecInstruction` run a whole basic block
+///   before returning to `Run`.
+///
+/// `OPCODE` introduces the handler of an opcode and `END_OPCODE` finishes a
+/// handler that completed successfully.  Handlers that raise an exception
+/// just `return`.
+#ifdef THREADED_CODE
+#define DISPATCH(op)  goto *HANDLERS[op];
+#define OPCODE(op)    H_ ## op
+#define OPCODE_OTHER  H_OTHER
+#define END_OPCODE    goto commit
+#else
+#define DISPATCH(op)  switch (op)
+#define OPCODE(op)    case op
+#define OPCODE_OTHER  default
+#define END_OPCODE    break
+#endif
+
 /// Execute one instruction from a user-level program.
 ///
 /// If there is any kind of exception or interrupt, we invoke the exception
@@ -143,6 +192,14 @@ Mult(int a, int b, bool signedArith, int *hiPtr, int *loPtr) {
 /// software must increment the PC so execution begins at the instruction
 /// immediately after the syscall.
 ///
+/// With *THREADED_CODE*, after an instruction completes we tick the clock
+/// and go on with the next one ourselves, as long as it is the next
+/// sequential instruction; we return to `Run` (which ticks the clock for the
+/// last instruction) once a branch or jump takes effect, an exception is
+/// raised or the program is being single-stepped.  Interrupts are still
+/// checked after every single instruction, so the simulated timing is the
+/// same as with the `switch`.
+///
 /// This routine is re-entrant, in that it can be called multiple times
 /// concurrently -- one for each thread executing user code.  We get
 /// re-entrancy by never caching any data -- we always re-start the
@@ -153,101 +210,144 @@ Mult(int a, int b, bool signedArith, int *hiPtr, int *loPtr) {
 /// contents of memory, the translation table, and the register set.
 void
 Machine::ExecInstruction(const Instruction *instr) {
-  int nextLoadReg = 0;
-  int nextLoadValue = 0;  // Record delayed load operation, to apply in the
-                          // future.
+  int nextLoadReg;
+  int nextLoadValue;  // Record delayed load operation, to apply in the
+                      // future.
+  int      pcAfter;
+  bool     taken;  // Whether a branch or jump is taken.
+  int      sum, diff, tmp, value;
+  unsigned rs, rt, imm;
+
+#ifdef THREADED_CODE
+  // Handler addresses, indexed by opcode (cf. `encoding.hh`).
+  static const void *const HANDLERS[MAX_OPCODE + 1] = {
+      &&H_OTHER,    &&H_OP_ADD,   &&H_OP_ADDI,  &&H_OP_ADDIU,  // 0-3
+      &&H_OP_ADDU,  &&H_OP_AND,   &&H_OP_ANDI,  &&H_OP_BEQ,    // 4-7
+      &&H_OP_BGEZ,  &&H_OP_BGEZAL, &&H_OP_BGTZ, &&H_OP_BLEZ,   // 8-11
+      &&H_OP_BLTZ,  &&H_OP_BLTZAL, &&H_OP_BNE,  &&H_OTHER,     // 12-15
+      &&H_OP_DIV,   &&H_OP_DIVU,  &&H_OP_J,     &&H_OP_JAL,    // 16-19
+      &&H_OP_JALR,  &&H_OP_JR,    &&H_OP_LB,    &&H_OP_LBU,    // 20-23
+      &&H_OP_LH,    &&H_OP_LHU,   &&H_OP_LUI,   &&H_OP_LW,     // 24-27
+      &&H_OP_LWL,   &&H_OP_LWR,   &&H_OTHER,    &&H_OP_MFHI,   // 28-31
+      &&H_OP_MFLO,  &&H_OTHER,    &&H_OP_MTHI,  &&H_OP_MTLO,   // 32-35
+      &&H_OP_MULT,  &&H_OP_MULTU, &&H_OP_NOR,   &&H_OP_OR,     // 36-39
+      &&H_OP_ORI,   &&H_OTHER,    &&H_OP_SB,    &&H_OP_SH,     // 40-43
+      &&H_OP_SLL,   &&H_OP_SLLV,  &&H_OP_SLT,   &&H_OP_SLTI,   // 44-47
+      &&H_OP_SLTIU, &&H_OP_SLTU,  &&H_OP_SRA,   &&H_OP_SRAV,   // 48-51
+      &&H_OP_SRL,   &&H_OP_SRLV,  &&H_OP_SUB,   &&H_OP_SUBU,   // 52-55
+      &&H_OP_SW,    &&H_OP_SWL,   &&H_OP_SWR,   &&H_OP_XOR,    // 56-59
+      &&H_OP_XORI,  &&H_OP_SYSCALL, &&H_OP_UNIMP, &&H_OP_RES   // 60-63
+  };
+  Instruction next;  // Storage for the following instructions of the block.
+
+dispatch:
+#endif
+  nextLoadReg = 0;
+  nextLoadValue = 0;
 
   // Compute next pc, but do not install in case there is an error or
   // branch.
-  int      pcAfter = registers[NEXT_PC_REG] + 4;
-  int      sum, diff, tmp, value;
-  unsigned rs, rt, imm;
+  pcAfter = registers[NEXT_PC_REG] + 4;
+  taken = false;
 
   // Execute the instruction (cf. Kane's book).
-  switch (instr->opCode) {
-    case OP_ADD:
-      sum = registers[instr->rs] + registers[instr->rt];
-      if (!((registers[instr->rs] ^ registers[instr->rt]) & SIGN_BIT)
-            && (registers[instr->rs] ^ sum) & SIGN_BIT) {
+  DISPATCH(instr->opCode) {
+    OPCODE(OP_ADD):
+      if (AddOverflows(registers[instr->rs], registers[instr->rt], &sum)) {
           RaiseException(OVERFLOW_EXCEPTION, 0);
           return;
       }
       registers[instr->rd] = sum;
-      break;
+      END_OPCODE;
 
-    case OP_ADDI:
-      sum = registers[instr->rs] + instr->extra;
-      if (!((registers[instr->rs] ^ instr->extra) & SIGN_BIT)
-            && (instr->extra ^ sum) & SIGN_BIT) {
+    OPCODE(OP_ADDI):
+      if (AddOverflows(registers[instr->rs], instr->extra, &sum)) {
           RaiseException(OVERFLOW_EXCEPTION, 0);
           return;
       }
       registers[instr->rt] = sum;
-      break;
+      END_OPCODE;
 
-    case OP_ADDIU:
+    OPCODE(OP_ADDIU):
       registers[instr->rt] = registers[instr->rs] + instr->extra;
-      break;
+      END_OPCODE;
 
-    case OP_ADDU:
+    OPCODE(OP_ADDU):
       registers[instr->rd] = registers[instr->rs] + registers[instr->rt];
-      break;
+      END_OPCODE;
 
-    case OP_AND:
+    OPCODE(OP_AND):
       registers[instr->rd] = registers[instr->rs] & registers[instr->rt];
-      break;
+      END_OPCODE;
 
-    case OP_ANDI:
+    OPCODE(OP_ANDI):
       registers[instr->rt] = registers[instr->rs] & (instr->extra & 0xFFFF);
-      break;
+      END_OPCODE;
 
-    case OP_BEQ:
-      if (registers[instr->rs] == registers[instr->rt])
+    OPCODE(OP_BEQ):
+      if (registers[instr->rs] == registers[instr->rt]) {
           pcAfter = registers[NEXT_PC_REG] + IndexToAddr(instr->extra);
-      break;
+          taken = true;
+      }
+      END_OPCODE;
 
-    case OP_BGEZAL:
+    OPCODE(OP_BGEZAL):
       registers[RET_ADDR_REG] = registers[NEXT_PC_REG] + 4;
 
-    case OP_BGEZ:
-      if (!(registers[instr->rs] & SIGN_BIT))
+    OPCODE(OP_BGEZ):
+      if (!(registers[instr->rs] & SIGN_BIT)) {
           pcAfter = registers[NEXT_PC_REG] + IndexToAddr(instr->extra);
-      break;
+          taken = true;
+      }
+      END_OPCODE;
 
-    case OP_BGTZ:
-      if (registers[instr->rs] > 0)
+    OPCODE(OP_BGTZ):
+      if (registers[instr->rs] > 0) {
           pcAfter = registers[NEXT_PC_REG] + IndexToAddr(instr->extra);
-      break;
+          taken = true;
+      }
+      END_OPCODE;
 
-    case OP_BLEZ:
-      if (registers[instr->rs] <= 0)
+    OPCODE(OP_BLEZ):
+      if (registers[instr->rs] <= 0) {
           pcAfter = registers[NEXT_PC_REG] + IndexToAddr(instr->extra);
-      break;
+          taken = true;
+      }
+      END_OPCODE;
 
-    case OP_BLTZAL:
+    OPCODE(OP_BLTZAL):
       registers[RET_ADDR_REG] = registers[NEXT_PC_REG] + 4;
 
-    case OP_BLTZ:
-      if (registers[instr->rs] & SIGN_BIT)
+    OPCODE(OP_BLTZ):
+      if (registers[instr->rs] & SIGN_BIT) {
           pcAfter = registers[NEXT_PC_REG] + IndexToAddr(instr->extra);
-      break;
+          taken = true;
+      }
+      END_OPCODE;
 
-    case OP_BNE:
-      if (registers[instr->rs] != registers[instr->rt])
+    OPCODE(OP_BNE):
+      if (registers[instr->rs] != registers[instr->rt]) {
           pcAfter = registers[NEXT_PC_REG] + IndexToAddr(instr->extra);
-      break;
+          taken = true;
+      }
+      END_OPCODE;
 
-    case OP_DIV:
+    OPCODE(OP_DIV):
       if (registers[instr->rt] == 0) {
           registers[LO_REG] = 0;
           registers[HI_REG] = 0;
+      } else if (registers[instr->rt] == -1) {
+          // Negate in unsigned arithmetic: the only quotient that does not
+          // fit, `INT_MIN / -1`, would trap on the host.
+          registers[LO_REG] = (int) -(unsigned) registers[instr->rs];
+          registers[HI_REG] = 0;
       } else {
           registers[LO_REG] = registers[instr->rs] / registers[instr->rt];
           registers[HI_REG] = registers[instr->rs] % registers[instr->rt];
       }
-      break;
+      END_OPCODE;
 
-    case OP_DIVU:
+    OPCODE(OP_DIVU):
       rs = (unsigned) registers[instr->rs];
       rt = (unsigned) registers[instr->rt];
       if (rt == 0) {
@@ -259,25 +359,27 @@ Machine::ExecInstruction(const Instruction *instr) {
           tmp = rs % rt;
           registers[HI_REG] = (int) tmp;
       }
-      break;
+      END_OPCODE;
 
-    case OP_JAL:
+    OPCODE(OP_JAL):
       registers[RET_ADDR_REG] = registers[NEXT_PC_REG] + 4;
 
-    case OP_J:
+    OPCODE(OP_J):
       pcAfter = (pcAfter & 0xF0000000) | IndexToAddr(instr->extra);
-      break;
+      taken = true;
+      END_OPCODE;
 
-    case OP_JALR:
+    OPCODE(OP_JALR):
       registers[instr->rd] = registers[NEXT_PC_REG] + 4;
 
-    case OP_JR:
+    OPCODE(OP_JR):
       pcAfter = registers[instr->rs];
-      break;
+      taken = true;
+      END_OPCODE;
 
-    case OP_LB:
+    OPCODE(OP_LB):
 
-    case OP_LBU:
+    OPCODE(OP_LBU):
       tmp = registers[instr->rs] + instr->extra;
       if (!ReadMem(tmp, 1, &value)) return;
 
@@ -286,11 +388,11 @@ Machine::ExecInstruction(const Instruction *instr) {
 
       nextLoadReg = instr->rt;
       nextLoadValue = value;
-      break;
+      END_OPCODE;
 
-    case OP_LH:
+    OPCODE(OP_LH):
 
-    case OP_LHU:
+    OPCODE(OP_LHU):
       tmp = registers[instr->rs] + instr->extra;
       if (tmp & 0x1) {
           RaiseException(ADDRESS_ERROR_EXCEPTION, tmp);
@@ -303,14 +405,14 @@ Machine::ExecInstruction(const Instruction *instr) {
 
       nextLoadReg = instr->rt;
       nextLoadValue = value;
-      break;
+      END_OPCODE;
 
-    case OP_LUI:
+    OPCODE(OP_LUI):
       DEBUG('m', "Executing: LUI r%d,%d\n", instr->rt, instr->extra);
       registers[instr->rt] = instr->extra << 16;
-      break;
+      END_OPCODE;
 
-    case OP_LW:
+    OPCODE(OP_LW):
       tmp = registers[instr->rs] + instr->extra;
       if (tmp & 0x3) {
           RaiseException(ADDRESS_ERROR_EXCEPTION, tmp);
@@ -319,9 +421,9 @@ Machine::ExecInstruction(const Instruction *instr) {
       if (!ReadMem(tmp, 4, &value)) return;
       nextLoadReg = instr->rt;
       nextLoadValue = value;
-      break;
+      END_OPCODE;
 
-    case OP_LWL:
+    OPCODE(OP_LWL):
       tmp = registers[instr->rs] + instr->extra;
 
       // `ReadMem` assumes all 4 byte requests are aligned on an even
@@ -349,9 +451,9 @@ Machine::ExecInstruction(const Instruction *instr) {
             break;
       }
       nextLoadReg = instr->rt;
-      break;
+      END_OPCODE;
 
-    case OP_LWR:
+    OPCODE(OP_LWR):
       tmp = registers[instr->rs] + instr->extra;
 
       // `ReadMem` assumes all 4 byte requests are aligned on an even
@@ -379,131 +481,129 @@ Machine::ExecInstruction(const Instruction *instr) {
             break;
       }
       nextLoadReg = instr->rt;
-      break;
+      END_OPCODE;
 
-    case OP_MFHI:
+    OPCODE(OP_MFHI):
       registers[instr->rd] = registers[HI_REG];
-      break;
+      END_OPCODE;
 
-    case OP_MFLO:
+    OPCODE(OP_MFLO):
       registers[instr->rd] = registers[LO_REG];
-      break;
+      END_OPCODE;
 
-    case OP_MTHI:
+    OPCODE(OP_MTHI):
       registers[HI_REG] = registers[instr->rs];
-      break;
+      END_OPCODE;
 
-    case OP_MTLO:
+    OPCODE(OP_MTLO):
       registers[LO_REG] = registers[instr->rs];
-      break;
+      END_OPCODE;
 
-    case OP_MULT:
+    OPCODE(OP_MULT):
       Mult(registers[instr->rs], registers[instr->rt],
            true, &registers[HI_REG], &registers[LO_REG]);
-      break;
+      END_OPCODE;
 
-    case OP_MULTU:
+    OPCODE(OP_MULTU):
       Mult(registers[instr->rs], registers[instr->rt],
            false, &registers[HI_REG], &registers[LO_REG]);
-      break;
+      END_OPCODE;
 
-    case OP_NOR:
+    OPCODE(OP_NOR):
       registers[instr->rd] = ~(registers[instr->rs] | registers[instr->rt]);
-      break;
+      END_OPCODE;
 
-    case OP_OR:
+    OPCODE(OP_OR):
       registers[instr->rd] = registers[instr->rs] | registers[instr->rt];
-      break;
+      END_OPCODE;
 
-    case OP_ORI:
+    OPCODE(OP_ORI):
       registers[instr->rt] = registers[instr->rs] | (instr->extra & 0xFFFF);
-      break;
+      END_OPCODE;
 
-    case OP_SB:
+    OPCODE(OP_SB):
       if (!WriteMem((unsigned) (registers[instr->rs] + instr->extra),
                     1, registers[instr->rt]))
           return;
-      break;
+      END_OPCODE;
 
-    case OP_SH:
+    OPCODE(OP_SH):
       if (!WriteMem((unsigned) (registers[instr->rs] + instr->extra),
                     2, registers[instr->rt]))
           return;
-      break;
+      END_OPCODE;
 
-    case OP_SLL:
+    OPCODE(OP_SLL):
       registers[instr->rd] = registers[instr->rt] << instr->extra;
-      break;
+      END_OPCODE;
 
-    case OP_SLLV:
+    OPCODE(OP_SLLV):
       registers[instr->rd] = registers[instr->rt] << (registers[instr->rs] & 0x1F);
-      break;
+      END_OPCODE;
 
-    case OP_SLT:
+    OPCODE(OP_SLT):
       if (registers[instr->rs] < registers[instr->rt]) registers[instr->rd] = 1;
       else registers[instr->rd] = 0;
-      break;
+      END_OPCODE;
 
-    case OP_SLTI:
+    OPCODE(OP_SLTI):
       if (registers[instr->rs] < instr->extra) registers[instr->rt] = 1;
       else registers[instr->rt] = 0;
-      break;
+      END_OPCODE;
 
-    case OP_SLTIU:
+    OPCODE(OP_SLTIU):
       rs = registers[instr->rs];
       imm = instr->extra;
       if (rs < imm) registers[instr->rt] = 1;
       else registers[instr->rt] = 0;
-      break;
+      END_OPCODE;
 
-    case OP_SLTU:
+    OPCODE(OP_SLTU):
       rs = registers[instr->rs];
       rt = registers[instr->rt];
       if (rs < rt) registers[instr->rd] = 1;
       else registers[instr->rd] = 0;
-      break;
+      END_OPCODE;
 
-    case OP_SRA:
+    OPCODE(OP_SRA):
       registers[instr->rd] = registers[instr->rt] >> instr->extra;
-      break;
+      END_OPCODE;
 
-    case OP_SRAV:
+    OPCODE(OP_SRAV):
       registers[instr->rd] = registers[instr->rt] >> (registers[instr->rs] & 0x1F);
-      break;
+      END_OPCODE;
 
-    case OP_SRL:
+    OPCODE(OP_SRL):
       tmp = registers[instr->rt];
       tmp >>= instr->extra;
       registers[instr->rd] = tmp;
-      break;
+      END_OPCODE;
 
-    case OP_SRLV:
+    OPCODE(OP_SRLV):
       tmp = registers[instr->rt];
       tmp >>= registers[instr->rs] & 0x1F;
       registers[instr->rd] = tmp;
-      break;
+      END_OPCODE;
 
-    case OP_SUB:
-      diff = registers[instr->rs] - registers[instr->rt];
-      if ((registers[instr->rs] ^ registers[instr->rt]) & SIGN_BIT
-            && (registers[instr->rs] ^ diff) & SIGN_BIT) {
+    OPCODE(OP_SUB):
+      if (SubOverflows(registers[instr->rs], registers[instr->rt], &diff)) {
           RaiseException(OVERFLOW_EXCEPTION, 0);
           return;
       }
       registers[instr->rd] = diff;
-      break;
+      END_OPCODE;
 
-    case OP_SUBU:
+    OPCODE(OP_SUBU):
       registers[instr->rd] = registers[instr->rs] - registers[instr->rt];
-      break;
+      END_OPCODE;
 
-    case OP_SW:
+    OPCODE(OP_SW):
       if (!WriteMem((unsigned) (registers[instr->rs] + instr->extra),
                     4, registers[instr->rt]))
           return;
-      break;
+      END_OPCODE;
 
-    case OP_SWL:
+    OPCODE(OP_SWL):
       tmp = registers[instr->rs] + instr->extra;
 
       // The little endian/big endian swap code would fail (I think) if
@@ -527,9 +627,9 @@ Machine::ExecInstruction(const Instruction *instr) {
             break;
       }
       if (!WriteMem(tmp & ~0x3, 4, value)) return;
-      break;
+      END_OPCODE;
 
-    case OP_SWR:
+    OPCODE(OP_SWR):
       tmp = registers[instr->rs] + instr->extra;
 
       // The little endian/big endian swap code would fail (I think) if
@@ -553,30 +653,33 @@ Machine::ExecInstruction(const Instruction *instr) {
             break;
       }
       if (!WriteMem(tmp & ~0x3, 4, value)) return;
-      break;
+      END_OPCODE;
 
-    case OP_SYSCALL:
+    OPCODE(OP_SYSCALL):
       RaiseException(SYSCALL_EXCEPTION, 0);
       return;
 
-    case OP_XOR:
+    OPCODE(OP_XOR):
       registers[instr->rd] = registers[instr->rs] ^ registers[instr->rt];
-      break;
+      END_OPCODE;
 
-    case OP_XORI:
+    OPCODE(OP_XORI):
       registers[instr->rt] = registers[instr->rs] ^ (instr->extra & 0xFFFF);
-      break;
+      END_OPCODE;
 
-    case OP_RES:
+    OPCODE(OP_RES):
 
-    case OP_UNIMP:
+    OPCODE(OP_UNIMP):
       RaiseException(ILLEGAL_INSTR_EXCEPTION, 0);
       return;
 
-    default:
+    OPCODE_OTHER:
       ASSERT(false);
   }
 
+#ifdef THREADED_CODE
+commit:
+#endif
   // Now we have successfully executed the instruction.
 
   // Do any delayed load operation.
@@ -587,4 +690,147 @@ Machine::ExecInstruction(const Instruction *instr) {
     // For debugging, in case we are jumping into lala-land.
   registers[PC_REG] = registers[NEXT_PC_REG];
   registers[NEXT_PC_REG] = pcAfter;
+
+  // After the delay slot of a taken branch or jump comes its target.
+  branched = branchTaken;
+  branchTaken = taken;
+
+#ifdef THREADED_CODE
+  // Keep going while we stay inside the basic block.
+  if (singleStepper || registers[PC_REG] != registers[PREV_PC_REG] + 4)
+      return;
+  Tick();
+  if (!FetchInstruction(&next)) return;
+  if (fuseSequences && ExecFused(&next)) return;
+  instr = &next;
+  goto dispatch;
+#endif
+}
+
+/// Run a fused sequence of instructions.
+///
+/// The sequences were picked after the counts printed by `SequenceProfile`
+/// (option `-sq`):
+///
+/// * `LUI` followed by `ORI`, `ADDIU` or `ADDU`, building a constant or the
+///   address of a global;
+/// * `SLL` followed by `ADDU`, scaling an index and adding it to a base;
+/// * `LW` followed by `SLL` or `ADDU`, a load and the instruction in its
+///   delay slot;
+/// * `ADDIU`, `SLTI` and then `BNE` or `BEQ`, stepping and testing a loop
+///   counter.
+///
+/// Each instruction has the very same effect as in `ExecInstruction`,
+/// including the delayed load done after it: the instruction after a `LW`
+/// still sees the old value of the loaded register, and the branch ending a
+/// sequence leaves its delay slot to be run as usual.  A sequence is only
+/// fused when:
+///
+/// * its first instruction is not in a delay slot, and all of it lies in
+///   the same page, so the rest is found next to it in physical memory;
+/// * no interrupt falls due and no yield is pending before its last
+///   instruction, so the ticks of the others can be counted at once;
+/// * only the first instruction may fail, and it is checked before
+///   changing anything, so the sequence can be left to `ExecInstruction`.
+bool
+Machine::ExecFused(const Instruction *instr) {
+    unsigned length;
+    switch (instr->opCode) {
+        case OP_LUI:
+        case OP_SLL:
+        case OP_LW:
+            length = 2;
+            break;
+        case OP_ADDIU:
+            length = 3;
+            break;
+        default:
+            return false;
+    }
+
+    unsigned pc = registers[PC_REG];
+    unsigned offset = pc & (mmu.GetPageSize() - 1);
+    if (singleStepper || (unsigned) registers[NEXT_PC_REG] != pc + 4
+          || offset + 4 * length > mmu.GetPageSize()
+          || interrupt->IsYieldPending()
+          || stats->totalTicks + (length - 1) * USER_TICK
+               >= interrupt->NextDue())
+        return false;
+
+    unsigned nextAddr = fetchedAddr + 4;
+    const Instruction *next = decodeCache.Lookup(nextAddr,
+      WordToHost(*(unsigned *) &mmu.mainMemory[nextAddr]));
+    int pcAfter = pc + 4 * length + 4;
+    bool taken = false;
+    int value;
+
+    switch (instr->opCode) {
+        case OP_LUI:
+            if (next->opCode != OP_ORI && next->opCode != OP_ADDIU
+                  && next->opCode != OP_ADDU)
+                return false;
+            registers[instr->rt] = instr->extra << 16;
+            DelayedLoad(0, 0);
+            if (next->opCode == OP_ORI)
+                registers[next->rt] = registers[next->rs]
+                                        | (next->extra & 0xFFFF);
+            else if (next->opCode == OP_ADDIU)
+                registers[next->rt] = registers[next->rs] + next->extra;
+            else
+                registers[next->rd] = registers[next->rs]
+                                        + registers[next->rt];
+            break;
+
+        case OP_SLL:
+            if (next->opCode != OP_ADDU) return false;
+            registers[instr->rd] = registers[instr->rt] << instr->extra;
+            DelayedLoad(0, 0);
+            registers[next->rd] = registers[next->rs] + registers[next->rt];
+            break;
+
+        case OP_LW: {
+            if (next->opCode != OP_SLL && next->opCode != OP_ADDU)
+                return false;
+            unsigned addr = registers[instr->rs] + instr->extra;
+            if (addr & 0x3 || mmu.ReadMem(addr, 4, &value) != NO_EXCEPTION)
+                return false;  // Let `ExecInstruction` raise it.
+            DelayedLoad(instr->rt, value);
+            if (next->opCode == OP_SLL)
+                registers[next->rd] = registers[next->rt] << next->extra;
+            else
+                registers[next->rd] = registers[next->rs]
+                                        + registers[next->rt];
+            break;
+        }
+
+        case OP_ADDIU: {
+            unsigned lastAddr = fetchedAddr + 8;
+            const Instruction *last = decodeCache.Lookup(lastAddr,
+              WordToHost(*(unsigned *) &mmu.mainMemory[lastAddr]));
+            if (next->opCode != OP_SLTI
+                  || (last->opCode != OP_BNE && last->opCode != OP_BEQ))
+                return false;
+            registers[instr->rt] = registers[instr->rs] + instr->extra;
+            DelayedLoad(0, 0);
+            registers[next->rt] = registers[next->rs] < next->extra ? 1 : 0;
+            DelayedLoad(0, 0);
+            bool equal = registers[last->rs] == registers[last->rt];
+            if (equal == (last->opCode == OP_BEQ)) {
+                pcAfter = pc + 12 + IndexToAddr(last->extra);
+                taken = true;
+            }
+            break;
+        }
+    }
+
+    // The last instruction is done like in `ExecInstruction`.
+    DelayedLoad(0, 0);
+    registers[PREV_PC_REG] = pc + 4 * (length - 1);
+    registers[PC_REG]      = pc + 4 * length;
+    registers[NEXT_PC_REG] = pcAfter;
+    branched    = false;
+    branchTaken = taken;
+
+    interrupt->AdvanceUserTicks(length - 1);
+    return true;
 }
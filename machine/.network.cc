@@ -68,17 +68,29 @@ Network::~Network() {
 /// If a packet is already buffered, we simply delay reading the incoming
 /// packet.  In real life, the incoming packet might be dropped if we cannot
 /// read it in time.
+///
+/// When `eventLog` is replaying, packets come from it instead of the socket.
 void
 Network::CheckPktAvail() {
     // Schedule the next time to poll for a packet.
     interrupt->Schedule(NetworkReadPoll, this, NETWORK_TIME, NETWORK_RECV_INT);
 
     if (inHdr.length != 0) return; // Do nothing if packet is already buffered.
-    if (!PollSocket(sock)) return; // Do nothing if no packet to be read.
 
-    // Otherwise, read packet in.
     char *buffer = new char [MAX_WIRE_SIZE];
-    ReadFromSocket(sock, buffer, MAX_WIRE_SIZE);
+    if (eventLog && eventLog->IsReplaying()) {
+        if (!eventLog->ReplayDue(PACKET_EVENT, buffer, MAX_WIRE_SIZE)) {
+            delete [] buffer;
+            return;
+        }
+    } else {
+        if (!PollSocket(sock)) {  // Do nothing if no packet to be read.
+            delete [] buffer;
+            return;
+        }
+        ReadFromSocket(sock, buffer, MAX_WIRE_SIZE);
+        if (eventLog) eventLog->Record(PACKET_EVENT, buffer, MAX_WIRE_SIZE);
+    }
 
     // Divide packet into header and data.
     inHdr = *(PacketHeader *) buffer;
@@ -107,6 +119,9 @@ Network::SendDone() {
 ///
 /// Note we always pad out a packet to `MAX_WIRE_SIZE` before putting it into
 /// the socket, because it is simpler at the receive end.
+///
+/// When `eventLog` is replaying, whether the packet is lost comes from it,
+/// and nothing is sent: the other machines are replaying their own logs.
 void
 Network::Send(PacketHeader hdr, const char *data) {
     ASSERT(data);
@@ -121,10 +136,18 @@ Network::Send(PacketHeader hdr, const char *data) {
 
     interrupt->Schedule(NetworkSendDone, this, NETWORK_TIME, NETWORK_SEND_INT);
 
-    if (Random() % 100 >= chanceToWork * 100) { // Emulate a lost packet.
+    bool lost;
+    bool replaying = eventLog && eventLog->IsReplaying();
+    if (!replaying || !eventLog->Replay(LOSS_EVENT, &lost, sizeof lost)) {
+        lost = Random() % 100 >= chanceToWork * 100;
+        if (eventLog && !replaying)
+            eventLog->Record(LOSS_EVENT, &lost, sizeof lost);
+    }
+    if (lost) { // Emulate a lost packet.
         DEBUG('k', "oops, lost it!\n");
         return;
     }
+    if (replaying) return;
 
     // Concatenate `hdr` and `data` into a single buffer, and send it out.
     char *buffer = new char [MAX_WIRE_SIZE];
@@ -0,0 +1,209 @@
+/// DO NOT CHANGE -- part of the machine emulation
+///
+/// Copyright (c) 2016-2019 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#include ".sampling_profile.hh"
+#include "threads/system.hh"
+
+#include <stdio.h>
+#include <string.h>
+
+/// Dummy function because C++ does not allow pointers to member functions.
+static void
+SampleHandler(void *arg) {
+    ASSERT(arg);
+
+    SamplingProfile *p = (SamplingProfile *) arg;
+    p->Sample();
+}
+
+SamplingProfile::SamplingProfile(unsigned ticks, const char *symbolFile)
+  : symbols(symbolFile) {
+    ASSERT(ticks > 0);
+
+    period     = ticks;
+    capacity   = 64;
+    stacks     = new Stack [capacity];
+    numStacks  = 0;
+    numSamples = 0;
+    for (unsigned i = 0; i < capacity; i++) stacks[i].thread = nullptr;
+
+    timer = new Timer(SampleHandler, this, ticks, SAMPLER_INT);
+}
+
+SamplingProfile::~SamplingProfile() {
+    delete timer;
+    for (unsigned i = 0; i < capacity; i++) delete [] stacks[i].thread;
+    delete [] stacks;
+}
+
+bool
+SamplingProfile::IsReturnAddress(unsigned address) const {
+    int word;
+    if (address < 8 || machine->GetMMU()->PeekWord(address - 8, &word)
+                         != NO_EXCEPTION)
+        return false;
+
+    Instruction call;
+    call.value = word;
+    call.Decode();
+    return call.opCode == OP_JAL || call.opCode == OP_JALR;
+}
+
+unsigned
+SamplingProfile::FunctionOf(unsigned address) const {
+    unsigned s = symbols.Find(address);
+    return s < symbols.Length() ? symbols.GetAddress(s) : address;
+}
+
+void
+SamplingProfile::AddFrame(Stack *stack, unsigned address) const {
+    ASSERT(stack);
+
+    unsigned function = FunctionOf(address);
+    if (stack->depth < MAX_DEPTH
+          && (stack->depth == 0 || stack->frames[stack->depth - 1] != function))
+        stack->frames[stack->depth++] = function;
+}
+
+/// Runs as an interrupt handler, so the machine status is that of the
+/// code interrupted, as told by `Interrupt::GetInterruptedStatus`.
+void
+SamplingProfile::Sample() {
+    Stack stack;
+    stack.thread = (char *) currentThread->GetName();
+    stack.depth  = 0;
+
+    switch (interrupt->GetInterruptedStatus()) {
+        case IDLE_MODE:
+            stack.place = IN_IDLE;
+            break;
+
+        case SYSTEM_MODE:
+            stack.place = IN_KERNEL;
+            break;
+
+        default: {
+            stack.place = IN_USER;
+
+            const int *registers = machine->GetRegisters();
+            AddFrame(&stack, registers[PC_REG]);
+            if (IsReturnAddress(registers[RET_ADDR_REG]))
+                AddFrame(&stack, registers[RET_ADDR_REG]);
+
+            // The callers' return addresses are saved near the top of the
+            // stack.
+            unsigned sp = registers[STACK_REG];
+            for (unsigned i = 0; i < SCAN_WORDS && stack.depth < MAX_DEPTH;
+                   i++) {
+                int word;
+                if (machine->GetMMU()->PeekWord(sp + 4 * i, &word)
+                      != NO_EXCEPTION)
+                    break;
+                if (IsReturnAddress(word)) AddFrame(&stack, word);
+            }
+            break;
+        }
+    }
+
+    Count(stack);
+}
+
+unsigned
+SamplingProfile::Hash(const Stack &stack) {
+    unsigned h = 2166136261U;  // FNV-1a.
+    for (const char *c = stack.thread; *c != '\0'; c++)
+        h = (h ^ (unsigned char) *c) * 16777619U;
+    h = (h ^ stack.place) * 16777619U;
+    for (unsigned i = 0; i < stack.depth; i++)
+        h = (h ^ stack.frames[i]) * 16777619U;
+    return h;
+}
+
+bool
+SamplingProfile::SameStack(const Stack &a, const Stack &b) {
+    if (a.place != b.place || a.depth != b.depth
+          || strcmp(a.thread, b.thread) != 0)
+        return false;
+    for (unsigned i = 0; i < a.depth; i++)
+        if (a.frames[i] != b.frames[i]) return false;
+    return true;
+}
+
+void
+SamplingProfile::Count(const Stack &stack) {
+    numSamples++;
+
+    // Keep the table at most half full.
+    if (2 * (numStacks + 1) > capacity) {
+        Stack *old = stacks;
+        unsigned oldCapacity = capacity;
+        capacity *= 2;
+        stacks = new Stack [capacity];
+        for (unsigned i = 0; i < capacity; i++) stacks[i].thread = nullptr;
+        for (unsigned i = 0; i < oldCapacity; i++) {
+            if (old[i].thread == nullptr) continue;
+            unsigned j = Hash(old[i]) & (capacity - 1);
+            while (stacks[j].thread != nullptr) j = (j + 1) & (capacity - 1);
+            stacks[j] = old[i];
+        }
+        delete [] old;
+    }
+
+    unsigned i = Hash(stack) & (capacity - 1);
+    for (; stacks[i].thread != nullptr; i = (i + 1) & (capacity - 1))
+        if (SameStack(stacks[i], stack)) {
+            stacks[i].count++;
+            return;
+        }
+
+    // The name of the thread may go away with it.
+    stacks[i] = stack;
+    stacks[i].thread = new char [strlen(stack.thread) + 1];
+    strcpy(stacks[i].thread, stack.thread);
+    stacks[i].count = 1;
+    numStacks++;
+}
+
+void
+SamplingProfile::PrintFrame(unsigned address) const {
+    unsigned s = symbols.Find(address);
+    if (s < symbols.Length() && symbols.GetAddress(s) == address)
+        printf("%s", symbols.GetName(s));
+    else
+        printf("0x%X", address);
+}
+
+void
+SamplingProfile::Print() const {
+    printf("Sampled stacks, one every %u ticks, %llu samples (folded):\n",
+           period, numSamples);
+
+    // Only done once, so picking the largest remaining one each time is
+    // good enough.
+    bool *printed = new bool [capacity];
+    memset(printed, 0, capacity * sizeof *printed);
+
+    for (unsigned n = 0; n < numStacks; n++) {
+        unsigned best = capacity;
+        for (unsigned i = 0; i < capacity; i++)
+            if (stacks[i].thread != nullptr && !printed[i]
+                  && (best == capacity || stacks[i].count > stacks[best].count))
+                best = i;
+        printed[best] = true;
+
+        const Stack &s = stacks[best];
+        printf("%s", s.thread);
+        if (s.place == IN_IDLE) printf(";[idle]");
+        else if (s.place == IN_KERNEL) printf(";[kernel]");
+        for (unsigned i = s.depth; i > 0; i--) {
+            printf(";");
+            PrintFrame(s.frames[i - 1]);
+        }
+        printf(" %llu\n", s.count);
+    }
+
+    delete [] printed;
+}
@@ -0,0 +1,105 @@
+/// Sampling profile of the threads running on Nachos.
+///
+/// Every so many ticks, a `Timer` of its own interrupts the machine and the
+/// profile notes which thread is running, and what it is doing: idling,
+/// running kernel code, or running user code -- and then, where.  The
+/// report printed when Nachos halts has one line per different stack, in
+/// the "folded" format read by flame graph tools:
+///
+///     main;__start;main;Multiply 1234
+///
+/// The user stack is recovered without any debugging information: after
+/// the program counter come the return address register and the words
+/// near the top of the stack that look like return addresses, that is,
+/// that point right after a `JAL` or `JALR` and its delay slot.  Frames
+/// are named after the functions found in the COFF file the program was
+/// built from (cf. `SymbolTable`), or else printed as addresses.
+///
+/// Taking a sample changes nothing: the interrupts are of type
+/// `SAMPLER_INT`, come at fixed intervals (so no random numbers are drawn),
+/// and memory is only looked at with `MMU::PeekWord`.  Time slices, random
+/// yields and page replacement go exactly as without the profile.
+///
+/// DO NOT CHANGE -- part of the machine emulation
+///
+/// Copyright (c) 2016-2019 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_MACHINE_SAMPLINGPROFILE__HH
+#define NACHOS_MACHINE_SAMPLINGPROFILE__HH
+
+#include ".symbol_table.hh"
+#include "timer.hh"
+
+class SamplingProfile {
+public:
+
+    /// Start taking a sample every `ticks` ticks, naming code after the
+    /// symbols in the COFF file `symbolFile` (may be null).
+    SamplingProfile(unsigned ticks, const char *symbolFile);
+
+    ~SamplingProfile();
+
+    /// Record what the machine was doing when interrupted.
+    void Sample();
+
+    /// Print the folded stacks, the most frequent first.
+    void Print() const;
+
+private:
+
+    /// Most frames recorded in a stack.
+    static const unsigned MAX_DEPTH = 8;
+
+    /// Number of words from the top of the user stack searched for return
+    /// addresses.
+    static const unsigned SCAN_WORDS = 64;
+
+    /// Where a sample was taken.
+    enum Place {
+        IN_USER,
+        IN_KERNEL,
+        IN_IDLE
+    };
+
+    struct Stack {
+        char *thread;  ///< Name of the thread; null if the entry is free.
+        Place place;
+        unsigned depth;  ///< Number of user frames.
+        unsigned frames[MAX_DEPTH];  ///< Innermost first.
+        unsigned long long count;  ///< Samples of this stack.
+    };
+
+    /// Return whether `address` may be where a call returns to.
+    bool IsReturnAddress(unsigned address) const;
+
+    /// Return the address of the function holding `address`, or `address`
+    /// itself if there are no symbols for it.
+    unsigned FunctionOf(unsigned address) const;
+
+    /// Add a frame for the code at `address` to `stack`, unless it is the
+    /// function of the frame before.
+    void AddFrame(Stack *stack, unsigned address) const;
+
+    /// Count one more sample of `stack`, adding it to the table if new.
+    void Count(const Stack &stack);
+
+    /// Print the name of the frame at `address`.
+    void PrintFrame(unsigned address) const;
+
+    static unsigned Hash(const Stack &stack);
+
+    static bool SameStack(const Stack &a, const Stack &b);
+
+    Timer *timer;
+    unsigned period;
+    SymbolTable symbols;
+
+    Stack *stacks;  ///< Hash table of the stacks seen, open addressed.
+    unsigned capacity;  ///< Size of `stacks`, a power of two.
+    unsigned numStacks;
+    unsigned long long numSamples;
+};
+
+#endif
@@ -0,0 +1,100 @@
+/// DO NOT CHANGE -- part of the machine emulation
+///
+/// Copyright (c) 2016-2019 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#include ".sequence_profile.hh"
+#include "lib/utility.hh"
+
+#include <stdio.h>
+#include <string.h>
+
+SequenceProfile::SequenceProfile() {
+    pairs   = new unsigned long long [NUM_OPS * NUM_OPS];
+    triples = new unsigned long long [NUM_OPS * NUM_OPS * NUM_OPS];
+    memset(pairs, 0, NUM_OPS * NUM_OPS * sizeof *pairs);
+    memset(triples, 0, NUM_OPS * NUM_OPS * NUM_OPS * sizeof *triples);
+    total = 0;
+
+    lastOps[0] = lastOps[1] = 0;
+    chained = 0;
+    lastPc = 0;
+    lastSequential = false;
+}
+
+SequenceProfile::~SequenceProfile() {
+    delete [] pairs;
+    delete [] triples;
+}
+
+void
+SequenceProfile::Record(unsigned pc, unsigned nextPc, unsigned opCode) {
+    ASSERT(opCode < NUM_OPS);
+
+    if (!lastSequential || pc != lastPc + 4)
+        chained = 0;  // Jumped here, or came from a delay slot.
+
+    if (chained >= 1)
+        pairs[lastOps[1] * NUM_OPS + opCode]++;
+    if (chained >= 2)
+        triples[(lastOps[0] * NUM_OPS + lastOps[1]) * NUM_OPS + opCode]++;
+
+    lastOps[0] = lastOps[1];
+    lastOps[1] = opCode;
+    if (chained < 2) chained++;
+    lastPc = pc;
+    lastSequential = nextPc == pc + 4;
+    total++;
+}
+
+/// Print the name of operation `op`, that is, the first word of its entry
+/// in `OP_STRINGS`.
+static void
+PrintOpName(unsigned op) {
+    const char *s = OP_STRINGS[op].string;
+    printf("%.*s", (int) strcspn(s, " "), s);
+}
+
+void
+SequenceProfile::PrintTop(const unsigned long long *counts, unsigned size,
+                          unsigned length) const {
+    // Only a few entries are shown, so picking the largest remaining one
+    // each time is good enough.
+    bool *shown = new bool [size];
+    memset(shown, 0, size * sizeof *shown);
+
+    for (unsigned rank = 1; rank <= SHOWN; rank++) {
+        unsigned best = size;
+        for (unsigned i = 0; i < size; i++)
+            if (!shown[i] && counts[i] != 0
+                  && (best == size || counts[i] > counts[best]))
+                best = i;
+        if (best == size) break;
+        shown[best] = true;
+
+        printf("%4u. %12llu %6.2f%%  ", rank, counts[best],
+               100.0 * counts[best] / total);
+        unsigned ops[3];
+        for (unsigned i = length, rest = best; i > 0; i--, rest /= NUM_OPS)
+            ops[i - 1] = rest % NUM_OPS;
+        for (unsigned i = 0; i < length; i++) {
+            if (i > 0) printf(" + ");
+            PrintOpName(ops[i]);
+        }
+        printf("\n");
+    }
+
+    delete [] shown;
+}
+
+void
+SequenceProfile::Print() const {
+    printf("Instruction sequences, out of %llu instructions:\n", total);
+    if (total == 0) return;
+
+    printf("Pairs:\n");
+    PrintTop(pairs, NUM_OPS * NUM_OPS, 2);
+    printf("Triples:\n");
+    PrintTop(triples, NUM_OPS * NUM_OPS * NUM_OPS, 3);
+}
@@ -0,0 +1,61 @@
+/// Profile of the instruction sequences run by user programs.
+///
+/// Counts how many times each pair and each triple of operations gets run
+/// back to back, one right after the other in memory.  The ranking printed
+/// when Nachos halts tells which sequences are worth fusing into a single
+/// operation of the simulator (cf. `Machine::ExecFused`): every run of a
+/// fused pair saves a whole fetch and dispatch.
+///
+/// An instruction only continues a sequence if it follows the previous one
+/// in memory, and the previous one was not itself in a delay slot, so the
+/// counts are those of the sequences that could actually be fused.
+///
+/// DO NOT CHANGE -- part of the machine emulation
+///
+/// Copyright (c) 2016-2019 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_MACHINE_SEQUENCEPROFILE__HH
+#define NACHOS_MACHINE_SEQUENCEPROFILE__HH
+
+#include ".encoding.hh"
+
+class SequenceProfile {
+public:
+
+    SequenceProfile();
+
+    ~SequenceProfile();
+
+    /// Count the instruction with operation `opCode` at address `pc`, about
+    /// to be run with `nextPc` as the following program counter.
+    void Record(unsigned pc, unsigned nextPc, unsigned opCode);
+
+    /// Print the most frequent pairs and triples.
+    void Print() const;
+
+private:
+
+    static const unsigned NUM_OPS = MAX_OPCODE + 1;
+
+    /// Number of sequences of each length shown by `Print`.
+    static const unsigned SHOWN = 20;
+
+    /// Print the `SHOWN` largest entries of the `size` counters in
+    /// `counts`, each standing for a sequence of `length` operations.
+    void PrintTop(const unsigned long long *counts, unsigned size,
+                  unsigned length) const;
+
+    unsigned long long *pairs;    ///< Indexed by `first * NUM_OPS + second`.
+    unsigned long long *triples;  ///< Likewise, with three operations.
+    unsigned long long total;     ///< Instructions recorded.
+
+    unsigned lastOps[2];  ///< Operations of the last two instructions.
+    unsigned chained;     ///< How many of `lastOps` form a sequence.
+    unsigned lastPc;
+    bool lastSequential;  ///< Whether the last instruction was followed by
+                          ///< the next one in memory.
+};
+
+#endif
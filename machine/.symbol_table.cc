@@ -0,0 +1,122 @@
+/// DO NOT CHANGE -- part of the machine emulation
+///
+/// Copyright (c) 2016-2019 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#include ".symbol_table.hh"
+#include ".endianness.hh"
+#include ".bin/coff.h"
+#include ".bin/extern/syms.h"
+#include "lib/utility.hh"
+
+#include <stdio.h>
+
+SymbolTable::SymbolTable(const char *fileName) {
+    symbols    = nullptr;
+    numSymbols = 0;
+    names      = nullptr;
+    if (fileName) Load(fileName);
+}
+
+SymbolTable::~SymbolTable() {
+    delete [] symbols;
+    delete [] names;
+}
+
+void
+SymbolTable::Load(const char *fileName) {
+    ASSERT(fileName);
+
+    FILE *f = fopen(fileName, "rb");
+    if (f == nullptr) {
+        fprintf(stderr, "Could not open symbol file `%s`.\n", fileName);
+        return;
+    }
+
+    coffFileHeader fileH;
+    HDRR symbolH;
+    if (fread(&fileH, sizeof fileH, 1, f) != 1
+          || ShortToHost(fileH.magic) != COFF_MIPSELMAGIC
+          || fseek(f, WordToHost(fileH.symbolPtr), SEEK_SET) != 0
+          || fread(&symbolH, sizeof symbolH, 1, f) != 1
+          || ShortToHost(symbolH.magic) != magicSym) {
+        fprintf(stderr, "File `%s` is not a MIPSEL COFF file with symbols.\n",
+                fileName);
+        fclose(f);
+        return;
+    }
+
+    unsigned numExternals = WordToHost(symbolH.iextMax);
+    unsigned stringsSize  = WordToHost(symbolH.issExtMax);
+    EXTR *externals = new EXTR [numExternals];
+    names           = new char [stringsSize + 1];
+    if (fseek(f, WordToHost(symbolH.cbExtOffset), SEEK_SET) != 0
+          || fread(externals, sizeof *externals, numExternals, f)
+               != numExternals
+          || fseek(f, WordToHost(symbolH.cbSsExtOffset), SEEK_SET) != 0
+          || fread(names, 1, stringsSize, f) != stringsSize) {
+        fprintf(stderr, "Symbol table of `%s` is too short.\n", fileName);
+        numExternals = 0;
+    }
+    names[stringsSize] = '\0';
+    fclose(f);
+
+    // Keep the code symbols, sorted by address.
+    symbols = new Symbol [numExternals];
+    for (unsigned i = 0; i < numExternals; i++) {
+        const SYMR *sym = &externals[i].asym;
+        unsigned name = WordToHost(sym->iss);
+        if (sym->sc != scText || name >= stringsSize) continue;
+
+        Symbol s;
+        s.address = WordToHost(sym->value);
+        s.name    = &names[name];
+        unsigned j = numSymbols++;
+        for (; j > 0 && symbols[j - 1].address > s.address; j--)
+            symbols[j] = symbols[j - 1];
+        symbols[j] = s;
+    }
+
+    delete [] externals;
+}
+
+unsigned
+SymbolTable::Length() const {
+    return numSymbols;
+}
+
+unsigned
+SymbolTable::Find(unsigned address) const {
+    // Binary search for the first symbol after `address`.
+    unsigned low = 0, high = numSymbols;
+    while (low < high) {
+        unsigned middle = (low + high) / 2;
+        if (symbols[middle].address <= address) low = middle + 1;
+        else high = middle;
+    }
+    return low > 0 ? low - 1 : numSymbols;
+}
+
+const char *
+SymbolTable::GetName(unsigned i) const {
+    ASSERT(i < numSymbols);
+    return symbols[i].name;
+}
+
+unsigned
+SymbolTable::GetAddress(unsigned i) const {
+    ASSERT(i < numSymbols);
+    return symbols[i].address;
+}
+
+void
+SymbolTable::PrintAddress(unsigned address) const {
+    printf("0x%08X", address);
+
+    unsigned s = Find(address);
+    if (s == numSymbols) return;
+    printf("  %s", symbols[s].name);
+    if (address != symbols[s].address)
+        printf("+0x%X", address - symbols[s].address);
+}
@@ -0,0 +1,56 @@
+/// Names of the functions of a user program.
+///
+/// Read from the external symbols of the COFF file the program was built
+/// from (the same ones listed by `.bin/out.c`), for the profilers to name
+/// the code they report on.  Only the external symbols are kept by the
+/// linker, so `static` functions get named after the function before them.
+///
+/// DO NOT CHANGE -- part of the machine emulation
+///
+/// Copyright (c) 2016-2019 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_MACHINE_SYMBOLTABLE__HH
+#define NACHOS_MACHINE_SYMBOLTABLE__HH
+
+class SymbolTable {
+public:
+
+    /// Read the text symbols of the COFF file `fileName`.
+    ///
+    /// If `fileName` is null, or cannot be read, the table is left empty.
+    SymbolTable(const char *fileName);
+
+    ~SymbolTable();
+
+    /// Return the number of symbols.
+    unsigned Length() const;
+
+    /// Return the index of the last symbol at or before `address`, or
+    /// `Length()` if there is none.
+    unsigned Find(unsigned address) const;
+
+    const char *GetName(unsigned i) const;
+
+    unsigned GetAddress(unsigned i) const;
+
+    /// Print `address`, and the symbol and offset it falls in.
+    void PrintAddress(unsigned address) const;
+
+private:
+
+    struct Symbol {
+        unsigned address;
+        char *name;
+    };
+
+    /// Read the symbols, complaining if the file is not right.
+    void Load(const char *fileName);
+
+    Symbol *symbols;  ///< Sorted by address.
+    unsigned numSymbols;
+    char *names;  ///< String space the names point into.
+};
+
+#endif
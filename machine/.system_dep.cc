@@ -374,3 +374,51 @@ DeallocBoundedArray(const char *ptr, unsigned size) {
 #endif
     delete [] (ptr - pgSize);
 }
+
+/// Return a zero-filled array of `size` bytes, mapped straight from the
+/// host, so that its pages only take memory once they are touched.
+///
+/// * `size` -- amount of space needed (in bytes).
+char *
+AllocZeroedArray(size_t size) {
+    ASSERT(size);
+
+    void *ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    ASSERT(ptr != MAP_FAILED);
+    return (char *) ptr;
+}
+
+/// Deallocate an array returned by `AllocZeroedArray`.
+///
+/// * `ptr` is the array to be deallocated.
+/// * `size` is the size of the array (in bytes).
+void
+DeallocZeroedArray(char *ptr, size_t size) {
+    ASSERT(ptr);
+    ASSERT(size);
+
+    munmap(ptr, size);
+}
+
+/// Map a file over an array returned by `AllocZeroedArray`.
+///
+/// * `ptr` is the array, which keeps its address.
+/// * `size` is the size of the array (in bytes).
+/// * `fd` is the open file to map.
+/// * `offset` is where the contents of the array start in the file.
+bool
+MapFileOver(char *ptr, size_t size, int fd, size_t offset) {
+    ASSERT(ptr);
+    ASSERT(size);
+
+    void *p = mmap(ptr, size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_FIXED, fd, offset);
+    return p != MAP_FAILED;
+}
+
+/// Return the size of the pages of the host, in bytes.
+unsigned
+HostPageSize() {
+    return sysconf(_SC_PAGESIZE);
+}
@@ -79,6 +79,25 @@ extern char *AllocBoundedArray(unsigned size);
 
 extern void DeallocBoundedArray(const char *p, unsigned size);
 
+/// Allocate, de-allocate a zero-filled array, which the host only backs
+/// with memory as its pages get used.
+
+extern char *AllocZeroedArray(size_t size);
+
+extern void DeallocZeroedArray(char *p, size_t size);
+
+/// Replace the `size` bytes at `p`, as returned by `AllocZeroedArray`, by a
+/// private copy of the file open as `fd`, starting at `offset`.  The host
+/// only reads the pages of the file as they get used, and writes to them
+/// do not reach the file.
+///
+/// Return false if the file cannot be mapped, as when `offset` is not a
+/// multiple of `HostPageSize`.
+
+extern bool MapFileOver(char *p, size_t size, int fd, size_t offset);
+
+extern unsigned HostPageSize();
+
 /// Other C library routines that are used by Nachos.
 /// These are assumed to be portable, so we do not include a wrapper.
 extern "C" {
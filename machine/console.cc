@@ -80,6 +80,9 @@ Console::~Console() {
 /// character has been grabbed out of the buffer by the Nachos kernel).
 /// Invoke the “read” interrupt handler, once the character has been put into
 /// the buffer.
+///
+/// When `eventLog` is replaying, characters come from it instead of the
+/// keyboard.
 void
 Console::CheckCharAvail() {
     char c;
@@ -87,11 +90,19 @@ Console::CheckCharAvail() {
     // Schedule the next time to poll for a packet.
     interrupt->Schedule(ConsoleReadPoll, this, CONSOLE_TIME, CONSOLE_READ_INT);
 
-    // Do nothing if character is already buffered, or none to be read.
-    if (incoming != EOF || !PollFile(readFileNo)) return;
+    // Do nothing if character is already buffered.
+    if (incoming != EOF) return;
+
+    if (eventLog && eventLog->IsReplaying()) {
+        if (!eventLog->ReplayDue(CONSOLE_EVENT, &c, sizeof c)) return;
+    } else {
+        // Do nothing if there is none to be read.
+        if (!PollFile(readFileNo)) return;
+        Read(readFileNo, &c, sizeof c);
+        if (eventLog) eventLog->Record(CONSOLE_EVENT, &c, sizeof c);
+    }
 
-    // Otherwise, read character and tell user about it.
-    Read(readFileNo, &c, sizeof c);
+    // Tell user about the character.
     incoming = c;
     stats->numConsoleCharsRead++;
     (*readHandler)(handlerArg);
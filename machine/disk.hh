@@ -87,14 +87,14 @@ private:
     void *handlerArg;  ///< Argument to interrupt handler.
     bool active;  ///< Is a disk operation in progress?
     unsigned lastSector;  ///< The previous disk request.
-    int bufferInit;  ///< When the track buffer started being loaded.
-                     // being loaded
+    unsigned long long bufferInit;  ///< When the track buffer started
+                                    ///< being loaded.
 
     /// Time to get to the new track.
     unsigned TimeToSeek(unsigned newSector, unsigned *rotate);
 
     /// Number of sectors between `to` and `from`.
-    unsigned ModuloDiff(unsigned to, unsigned from);
+    unsigned ModuloDiff(unsigned to, unsigned long long from);
 
     void UpdateLast(unsigned newSector);
 };
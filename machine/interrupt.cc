@@ -29,9 +29,15 @@
 static const char *INT_LEVEL_NAMES[] = { "disabled", "enabled" };
 static const char *INT_TYPE_NAMES[]  = {
     "timer", "disk", "console write", "console read",
-    "network send", "network recv"
+    "network send", "network recv", "sampler", "checkpoint"
 };
 
+/// Whether interrupts of `type` leave the machine as it was.
+static inline bool
+IsPassive(IntType type) {
+    return type == SAMPLER_INT || type == CHECKPOINT_INT;
+}
+
 static inline bool
 IsIntStatus(IntStatus s) {
     return 0 <= s && s < NUM_INT_STATUS;
@@ -50,7 +56,7 @@ IsIntType(IntType t) {
 /// * `time` is when (in simulated time) the interrupt is to occur.
 /// * `kind` is the hardware device that generated the interrupt.
 PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, void *param,
-                                   unsigned time, IntType kind) {
+                                   unsigned long long time, IntType kind) {
     ASSERT(func);
     ASSERT(IsIntType(kind));
 
@@ -58,6 +64,7 @@ PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, void *param,
     arg     = param;
     when    = time;
     type    = kind;
+    next    = nullptr;
 }
 
 /// Initialize the simulation of hardware device interrupts.
@@ -65,16 +72,28 @@ PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, void *param,
 /// Interrupts start disabled, with no interrupts pending, etc.
 Interrupt::Interrupt() {
     level         = INT_OFF;
-    pending       = new List<PendingInterrupt *>;
+    pending       = new Heap<PendingInterrupt *, unsigned long long>;
+    freePending   = nullptr;
     inHandler     = false;
     yieldOnReturn = false;
     status        = SYSTEM_MODE;
+    nextDue       = ULLONG_MAX;
+
+    interruptedStatus = SYSTEM_MODE;
+    pendingTimers     = 0;
+    pendingPassive    = 0;
 }
 
 /// De-allocate the data structures needed by the interrupt simulation.
 Interrupt::~Interrupt() {
-    while (!pending->IsEmpty()) delete pending->Pop();
+    while (!pending->IsEmpty()) delete pending->Pop(nullptr);
     delete pending;
+
+    while (freePending) {
+        PendingInterrupt *pend = freePending;
+        freePending = pend->next;
+        delete pend;
+    }
 }
 
 /// Change interrupts to be enabled or disabled, without advancing the
@@ -129,18 +148,28 @@ Interrupt::Enable() {
 /// Two things can cause `OneTick` to be called:
 /// * interrupts are re-enabled;
 /// * a user instruction is executed.
+///
+/// On a multiprocessor, only the clock of the CPU running goes forward (see
+/// `Multiprocessor::Advance`), and afterwards the CPU furthest behind gets
+/// to run.
 void
 Interrupt::OneTick() {
     MachineStatus old = status;
 
     // Advance simulated time.
-    if (status == SYSTEM_MODE) { stats->totalTicks += SYSTEM_TICK;
+    unsigned ticks;
+    if (status == SYSTEM_MODE) {
+        ticks = SYSTEM_TICK;
         stats->systemTicks += SYSTEM_TICK;
     } else {  // USER_PROGRAM
-        stats->totalTicks += USER_TICK;
+        ticks = USER_TICK;
         stats->userTicks += USER_TICK;
     }
-    DEBUG('I', "== Tick %u ==\n", stats->totalTicks);
+    if (multiprocessor)
+        multiprocessor->Advance(ticks);
+    else
+        stats->totalTicks += ticks;
+    DEBUG('I', "== Tick %llu ==\n", stats->totalTicks);
 
     // Check any pending interrupts are now ready to fire.
     ChangeLevel(INT_ON, INT_OFF);  // First, turn off interrupts (interrupt
@@ -155,6 +184,66 @@ Interrupt::OneTick() {
         currentThread->Yield();
         status = old;
     }
+    if (multiprocessor) multiprocessor->Rotate();
+}
+
+void
+Interrupt::UpdateNextDue() {
+    nextDue = pending->IsEmpty() ? ULLONG_MAX : pending->HeadKey();
+}
+
+/// Devices schedule an interrupt for almost every operation, so the
+/// `PendingInterrupt`s that have fired are kept for reuse instead of going
+/// back to the heap allocator.
+PendingInterrupt *
+Interrupt::NewPending(VoidFunctionPtr handler, void *arg,
+                      unsigned long long when, IntType type) {
+    PendingInterrupt *pend = freePending;
+
+    if (pend == nullptr) return new PendingInterrupt(handler, arg, when, type);
+
+    freePending = pend->next;
+    *pend = PendingInterrupt(handler, arg, when, type);
+    return pend;
+}
+
+void
+Interrupt::FreePending(PendingInterrupt *pend) {
+    ASSERT(pend);
+
+    pend->next  = freePending;
+    freePending = pend;
+}
+
+/// Account for `ticks` user instructions executed without checking for
+/// interrupts after each one.
+///
+/// Used by the simulator for the instructions before the next interrupt,
+/// and by the binary translator, which runs whole blocks of user code
+/// before coming back to `Machine::Run`.
+void
+Interrupt::AdvanceUserTicks(unsigned ticks) {
+    ASSERT(status == USER_MODE);
+    ASSERT(NextDue() - stats->totalTicks > ticks * USER_TICK);
+
+    stats->totalTicks += ticks * USER_TICK;
+    stats->userTicks  += ticks * USER_TICK;
+}
+
+/// The interrupts are taken out and put back in the order they would fire,
+/// so those due at the same time keep their order.
+void
+Interrupt::ShiftPending(long long ticks) {
+    Heap<PendingInterrupt *, unsigned long long> *oldPending = pending;
+    pending = new Heap<PendingInterrupt *, unsigned long long>;
+
+    PendingInterrupt *pend;
+    while ((pend = oldPending->Pop(nullptr)) != nullptr) {
+        pend->when += ticks;
+        pending->Insert(pend, pend->when);
+    }
+    delete oldPending;
+    UpdateNextDue();
 }
 
 /// Called from within an interrupt handler, to cause a context switch (for
@@ -206,40 +295,17 @@ void
 Interrupt::Halt() {
     printf("Machine halting!\n\n");
     stats->Print();
+    if (multiprocessor) multiprocessor->Print();
+#ifdef USER_PROGRAM
+    if (machine) machine->PrintProfile();
+#endif
     Cleanup();  // Never returns.
 }
 
-#ifdef DFS_TICKS_FIX
-/// Restart the total ticks statistic and the pending interrupts list.
-///
-/// This function makes sure Nachos keeps working even after overflowing the
-/// tick counter.  After some time (when `totalTicks` reach the maximum
-/// positive number) Nachos would schedule a pending interrupt at a negative
-/// time, and after that, it would hang.
-void
-Interrupt::RestartTicks() {
-    List<PendingInterrupt *> *oldPending = pending;
-    pending = new List<PendingInterrupt *>;
-
-    PendingInterrupt *i;
-    unsigned          oldWhen = 0;
-    while ((i = oldPending->SortedPop((int *) &oldWhen)) != nullptr) {
-        unsigned newWhen = oldWhen - stats->totalTicks;
-        pending->SortedInsert(i, newWhen);
-        DEBUG('i', "Interrupt at time %u re-scheduled at new time %u.\n",
-              oldWhen, newWhen);
-    }
-
-    delete oldPending;
-    stats->totalTicks = 0;
-    stats->tickResets += 1;
-}
-#endif
-
 /// Arrange for the CPU to be interrupted when simulated time reaches `now +
 /// when`.
 ///
-/// Implementation: just put it on a sorted list.
+/// Implementation: just put it on a heap, ordered by time.
 ///
 /// NOTE: the Nachos kernel should not call this routine directly.  Instead,
 /// it is only called by the hardware device simulators.
@@ -256,23 +322,16 @@ Interrupt::Schedule(VoidFunctionPtr handler, void *arg,
     ASSERT(fromNow);
     ASSERT(IsIntType(type));
 
-#ifdef DFS_TICKS_FIX
-    if (UINT_MAX - stats->totalTicks < fromNow) {
-        DEBUG('i', "WARNING: total tick count is too large and will be reset.\n");
-        RestartTicks();
-    }
-#else
-    // Terminate Nachos if the ticks overflowed.
-    ASSERT(UINT_MAX - stats->totalTicks > fromNow);
-#endif
-
-    unsigned when = stats->totalTicks + fromNow;
-    PendingInterrupt *toOccur = new PendingInterrupt(handler, arg, when, type);
+    unsigned long long when = stats->totalTicks + fromNow;
+    PendingInterrupt *toOccur = NewPending(handler, arg, when, type);
 
-    DEBUG('i', "Scheduling interrupt handler the %s at time = %u.\n",
+    DEBUG('i', "Scheduling interrupt handler the %s at time = %llu.\n",
           INT_TYPE_NAMES[type], when);
 
-    pending->SortedInsert(toOccur, when);
+    pending->Insert(toOccur, when);
+    UpdateNextDue();
+    if (type == TIMER_INT) pendingTimers++;
+    if (IsPassive(type)) pendingPassive++;
 }
 
 /// Check if an interrupt is scheduled to occur, and if so, fire it off.
@@ -286,36 +345,49 @@ Interrupt::Schedule(VoidFunctionPtr handler, void *arg,
 bool
 Interrupt::CheckIfDue(bool advanceClock) {
     MachineStatus old = status;
-    unsigned      when;
+    unsigned long long when;
 
     // Interrupts need to be disabled, to invoke an interrupt handler.
     ASSERT(level == INT_OFF);
 
     if (debug.IsEnabled('i')) DumpState();
-    PendingInterrupt *toOccur = pending->SortedPop((int *) &when);
 
-    if (!toOccur)  // No pending interrupts.
+    if (pending->IsEmpty())  // No pending interrupts.
     return false;
 
+    // Look at the earliest interrupt, but leave it in place until it is
+    // actually going to fire.
+    PendingInterrupt *toOccur = pending->Head();
+    when = pending->HeadKey();
+
     if (advanceClock && when > stats->totalTicks) {  // Advance the clock.
         stats->idleTicks += (when - stats->totalTicks);
         stats->totalTicks = when;
-    } else if (when > stats->totalTicks) {  // Not time yet, put it back.
-        pending->SortedInsert(toOccur, when);
+    } else if (when > stats->totalTicks) {  // Not time yet.
         return false;
     }
 
-    // Check if there is nothing more to do, and if so, quit.
-    if (status == IDLE_MODE && toOccur->type == TIMER_INT && pending->IsEmpty()) {
-        pending->SortedInsert(toOccur, when);
+    // Check if there is nothing more to do, and if so, quit.  That is the
+    // case if all that is left is the time-slice daemon, and samplers.
+    if (status == IDLE_MODE
+          && (toOccur->type == TIMER_INT || IsPassive(toOccur->type))
+          && pendingTimers <= 1
+          && pending->Length() == pendingTimers + pendingPassive)
         return false;
-    }
 
-    DEBUG('i', "Invoking interrupt handler for the %s at time %u.\n",
+    pending->Pop(nullptr);
+    UpdateNextDue();
+    if (toOccur->type == TIMER_INT) pendingTimers--;
+    if (IsPassive(toOccur->type)) pendingPassive--;
+
+    DEBUG('i', "Invoking interrupt handler for the %s at time %llu.\n",
             INT_TYPE_NAMES[toOccur->type], toOccur->when);
+    TRACE(TRACE_INTERRUPT, toOccur->type, toOccur->when, 0);
 #ifdef USER_PROGRAM
-    if (machine) machine->DelayedLoad(0, 0);
+    // A sampler leaves the user program exactly as it was.
+    if (machine && !IsPassive(toOccur->type)) machine->DelayedLoad(0, 0);
 #endif
+    interruptedStatus = old;
     inHandler = true;
     status = SYSTEM_MODE;  // Whatever we were doing, we are now going to be
                            // running in the kernel.
@@ -323,7 +395,7 @@ Interrupt::CheckIfDue(bool advanceClock) {
     status = old;  // Restore the machine status.
     inHandler = false;
 
-    delete toOccur;
+    FreePending(toOccur);
     return true;
 }
 
@@ -337,6 +409,36 @@ Interrupt::GetStatus() const {
     return status;
 }
 
+bool
+Interrupt::IsDevicePending() const {
+    return pending->Length() > pendingTimers + pendingPassive;
+}
+
+/// Only meant to be used between interrupt handlers.
+void
+Interrupt::SaveCpuStatus(CpuStatus *cpu) const {
+    ASSERT(cpu);
+    ASSERT(!inHandler);
+
+    cpu->level         = level;
+    cpu->status        = status;
+    cpu->yieldOnReturn = yieldOnReturn;
+}
+
+void
+Interrupt::RestoreCpuStatus(const CpuStatus &cpu) {
+    ASSERT(!inHandler);
+
+    level         = cpu.level;
+    status        = cpu.status;
+    yieldOnReturn = cpu.yieldOnReturn;
+}
+
+MachineStatus
+Interrupt::GetInterruptedStatus() const {
+    return interruptedStatus;
+}
+
 void
 Interrupt::SetStatus(MachineStatus st) {
     status = st;
@@ -348,14 +450,14 @@ static void
 PrintPending(PendingInterrupt *pend) {
     ASSERT(pend);
 
-    printf("    Handler %s, scheduled at %u.\n", INT_TYPE_NAMES[pend->type], pend->when);
+    printf("    Handler %s, scheduled at %llu.\n", INT_TYPE_NAMES[pend->type], pend->when);
 }
 
 /// Print the complete interrupt state -- the status, and all interrupts that
 /// are scheduled to occur in the future.
 void
 Interrupt::DumpState() {
-    DEBUG('I', "Time: %u, interrupts %s.\n", stats->totalTicks, INT_LEVEL_NAMES[level]);
+    DEBUG('I', "Time: %llu, interrupts %s.\n", stats->totalTicks, INT_LEVEL_NAMES[level]);
 
     if (pending->IsEmpty())
         DEBUG_CONT('I', "No pending interrupts.\n");
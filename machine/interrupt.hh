@@ -35,7 +35,7 @@
 #ifndef NACHOS_MACHINE_INTERRUPT__HH
 #define NACHOS_MACHINE_INTERRUPT__HH
 
-#include "lib/list.hh"
+#include "lib/heap.hh"
 
 /// Interrupts can be disabled (`INT_OFF`) or enabled (`INT_ON`).
 enum IntStatus {
@@ -57,6 +57,11 @@ enum MachineStatus {
 /// `IntType` records which hardware device generated an interrupt.  In
 /// Nachos, we support a hardware timer device, a disk, a console display and
 /// keyboard, and a network.
+///
+/// `SAMPLER_INT` comes from a timer that only watches the machine, for
+/// profiling: its handler must not change any state, so it neither
+/// completes delayed loads nor keeps an idle Nachos from halting.
+/// `CHECKPOINT_INT`, which saves the machine as it is, works the same way.
 enum IntType {
     TIMER_INT,
     DISK_INT,
@@ -64,6 +69,8 @@ enum IntType {
     CONSOLE_READ_INT,
     NETWORK_SEND_INT,
     NETWORK_RECV_INT,
+    SAMPLER_INT,
+    CHECKPOINT_INT,
     NUM_INT_TYPES
 };
 
@@ -76,14 +83,26 @@ class PendingInterrupt {
 public:
 
     /// initialize an interrupt that will occur in the future.
-    PendingInterrupt(VoidFunctionPtr func, void *param, unsigned time, IntType kind);
+    PendingInterrupt(VoidFunctionPtr func, void *param,
+                     unsigned long long time, IntType kind);
 
     VoidFunctionPtr handler;  ///< The function (in the hardware device
                               ///< emulator) to call when the interrupt
                               ///< occurs.
     void *arg;  ///< The argument to the function.
-    unsigned when;  ///< When the interrupt is supposed to fire.
+    unsigned long long when;  ///< When the interrupt is supposed to fire.
     IntType type;  ///< For debugging.
+    PendingInterrupt *next;  ///< Next unused interrupt, while in the pool
+                             ///< of `Interrupt`.
+};
+
+/// What each CPU of a multiprocessor has of its own in the interrupt
+/// hardware: whether its interrupts are enabled, what it is running, and
+/// whether it has to context switch.
+struct CpuStatus {
+    IntStatus level;
+    MachineStatus status;
+    bool yieldOnReturn;
 };
 
 /// The following class defines the data structures for the simulation
@@ -122,11 +141,24 @@ public:
     // Idle, kernel, user.
     MachineStatus GetStatus() const;
 
+    /// Return what the machine was doing when the interrupt handler being
+    /// run was invoked.
+    MachineStatus GetInterruptedStatus() const;
+
     void SetStatus(MachineStatus st);
 
     // Print interrupt state.
     void DumpState();
 
+    /// Return whether a device other than a timer has an interrupt pending,
+    /// that is, whether some I/O is in progress.
+    bool IsDevicePending() const;
+
+    /// Save the status of the CPU that is giving up the host into `cpu`,
+    /// or load the status of the one taking it from `cpu`.
+    void SaveCpuStatus(CpuStatus *cpu) const;
+    void RestoreCpuStatus(const CpuStatus &cpu);
+
     /// NOTE: the following are internal to the hardware simulation code.
     /// DO NOT call these directly.  I should make them “private”,
     /// but they need to be public since they are called by the
@@ -140,14 +172,48 @@ public:
     /// Advance simulated time.
     void OneTick();
 
+    /// Return the time at which the earliest pending interrupt is due, or
+    /// `ULLONG_MAX` if there is none.
+    ///
+    /// Kept up to date as interrupts are scheduled and fired, since the
+    /// simulator asks for it after every user instruction.
+    unsigned long long NextDue() const {
+        return nextDue;
+    }
+
+    /// Return whether a context switch has been requested for the next
+    /// `OneTick`.
+    bool IsYieldPending() const {
+        return yieldOnReturn;
+    }
+
+    /// Advance simulated time by `ticks` user instructions at once.
+    ///
+    /// Only valid when no pending interrupt falls due in the meantime, that
+    /// is, when calling `OneTick` that many times would not fire anything.
+    void AdvanceUserTicks(unsigned ticks);
+
+    /// Move every pending interrupt `ticks` later (or earlier, if
+    /// negative), for when simulated time jumps by as much, as when a
+    /// checkpoint is restored.
+    void ShiftPending(long long ticks);
+
 private:
     IntStatus level;  ///< Are interrupts enabled or disabled?
-    List<PendingInterrupt *> *pending;  ///< The list of interrupts scheduled
-                                        ///< to occur in the future.
+    Heap<PendingInterrupt *, unsigned long long> *pending;
+      ///< The interrupts scheduled to occur in the future, by time.
+    PendingInterrupt *freePending;  ///< Pool of `PendingInterrupt`s that
+                                    ///< can be reused, chained by `next`.
     bool inHandler;  ///< True if we are running an interrupt handler.
     bool yieldOnReturn;  ///< True if we are to context switch on return from
                          ///< the interrupt handler.
     MachineStatus status;  ///< Idle, kernel mode, user mode.
+    MachineStatus interruptedStatus;  ///< Status before the current
+                                      ///< handler was invoked.
+    unsigned pendingTimers;   ///< Number of `TIMER_INT`s in `pending`.
+    unsigned pendingPassive;  ///< Number of `SAMPLER_INT`s and
+                              ///< `CHECKPOINT_INT`s in `pending`.
+    unsigned long long nextDue;  ///< When the first interrupt in `pending` is due.
 
     /// These functions are internal to the interrupt simulation code.
 
@@ -157,10 +223,16 @@ private:
     /// SetLevel, without advancing the simulated time.
     void ChangeLevel(IntStatus old, IntStatus now);
 
-#ifdef DFS_TICKS_FIX
-    /// Restart total ticks and the pending interrupt list.
-    void RestartTicks();
-#endif
+    /// Recompute `nextDue` after changing `pending`.
+    void UpdateNextDue();
+
+    /// Take a `PendingInterrupt` from the pool, or allocate one if the pool
+    /// is empty.
+    PendingInterrupt *NewPending(VoidFunctionPtr handler, void *arg,
+                                 unsigned long long when, IntType type);
+
+    /// Give a `PendingInterrupt` back to the pool.
+    void FreePending(PendingInterrupt *pend);
 
 };
 
@@ -10,6 +10,8 @@
 #include "machine.hh"
 #include "threads/system.hh"
 
+#include <string.h>
+
 static inline bool
 IsExceptionType(ExceptionType t) {
     return 0 <= t && t < NUM_EXCEPTION_TYPES;
@@ -41,12 +43,62 @@ CheckEndian() {
 /// * `st` -- pointer to an object that performs single stepping, for
 ///   dropping into it after each user instruction is executed; if null,
 ///   execute normally, without single stepping.
-Machine::Machine(SingleStepper *st) {
+/// * `numPhysPages` is the number of pages of physical memory.
+/// * `pageSize` is the size of a page, in bytes; a power of two.
+Machine::Machine(SingleStepper *st, unsigned numPhysPages, unsigned pageSize)
+  : mmu(numPhysPages, pageSize), decodeCache(mmu.GetMemorySize()) {
     for (unsigned i = 0; i < NUM_TOTAL_REGS; i++) registers[i] = 0;
     for (unsigned i = 0; i < NUM_EXCEPTION_TYPES; i++) handlers[i] = nullptr;
 
     singleStepper = st;
+    profiling = false;
+    sequenceProfile = nullptr;
+    executionProfile = nullptr;
+    samplingProfile = nullptr;
+    instructionCache = nullptr;
+    dataCache = nullptr;
+    latencies = nullptr;
+    modelStalls = false;
+    stallTicks = 0;
+    branchTaken = false;
+    branched = false;
     CheckEndian();
+
+    // Tracing interrupts prints something on every tick.
+    batchTicks = !debug.IsEnabled('i') && !debug.IsEnabled('I');
+
+    // Fused sequences are run as a whole, fetching and tracing only their
+    // first instruction.
+    fuseSequences = batchTicks && !debug.IsEnabled('m')
+                      && !debug.IsEnabled('M') && !debug.IsEnabled('a')
+                      && !debug.IsEnabled('A') && !trace.IsEnabled(TRACE_FETCH)
+                      && !trace.IsEnabled(TRACE_TRANSLATE)
+                      && !trace.IsEnabled(TRACE_READ);
+    fetchedAddr = 0;
+
+#ifdef BINARY_TRANSLATION
+    // Translated code neither traces instructions nor checks interrupts
+    // one at a time, so keep to the interpreter when asked to.
+    if (debug.IsEnabled('m') || debug.IsEnabled('M') || debug.IsEnabled('A')
+          || debug.IsEnabled('i') || debug.IsEnabled('I')
+          || trace.IsEnabled(TRACE_FETCH) || trace.IsEnabled(TRACE_TRANSLATE)
+          || trace.IsEnabled(TRACE_READ) || trace.IsEnabled(TRACE_WRITE))
+        translator = nullptr;
+    else
+        translator = new BinaryTranslator(&mmu, registers, &decodeCache);
+#endif
+}
+
+Machine::~Machine() {
+#ifdef BINARY_TRANSLATION
+    delete translator;
+#endif
+    delete sequenceProfile;
+    delete executionProfile;
+    delete samplingProfile;
+    delete instructionCache;
+    delete dataCache;
+    delete latencies;
 }
 
 const int *
@@ -112,6 +164,7 @@ Machine::RaiseException(ExceptionType et, unsigned badVAddr) {
     ASSERT(IsExceptionType(et));
     ASSERT(handlers[et]);  // There must be a handler associated.
     DEBUG('m', "Exception: %s.\n", ExceptionTypeToString(et));
+    TRACE(TRACE_EXCEPTION, et, badVAddr, 0);
 
     //ASSERT(interrupt->GetStatus() == USER_MODE);
     registers[BAD_VADDR_REG] = badVAddr;
@@ -123,6 +176,115 @@ Machine::RaiseException(ExceptionType et, unsigned badVAddr) {
     interrupt->SetStatus(USER_MODE);
 }
 
+/// Every instruction has to be seen by the profiles.
+void
+Machine::StartProfiling() {
+    profiling = true;
+    StopShortcuts();
+}
+
+/// Neither fused sequences nor translated code are run from then on.
+void
+Machine::StopShortcuts() {
+    fuseSequences = false;
+#ifdef BINARY_TRANSLATION
+    delete translator;
+    translator = nullptr;
+#endif
+}
+
+void
+Machine::ProfileSequences() {
+    if (!sequenceProfile) sequenceProfile = new SequenceProfile;
+    StartProfiling();
+}
+
+void
+Machine::ProfileExecution(const char *symbolFile) {
+    if (!executionProfile)
+        executionProfile = new ExecutionProfile(mmu.GetPageSize(),
+                                                symbolFile);
+    StartProfiling();
+}
+
+/// Samples are taken by interrupts, not at every instruction, so nothing
+/// needs to be slowed down for them.
+void
+Machine::ProfileSamples(unsigned ticks, const char *symbolFile) {
+    if (!samplingProfile)
+        samplingProfile = new SamplingProfile(ticks, symbolFile);
+}
+
+/// Every fetch has to go through the cache, so no shortcuts are taken.
+void
+Machine::ModelInstructionCache(unsigned size, unsigned ways,
+                               unsigned lineSize, ReplacementPolicy policy) {
+    delete instructionCache;
+    instructionCache = new Cache(size, ways, lineSize, policy,
+                                 &stats->numICacheAccesses,
+                                 &stats->numICacheMisses, nullptr);
+    modelStalls = true;
+    StopShortcuts();
+}
+
+void
+Machine::ModelDataCache(unsigned size, unsigned ways, unsigned lineSize,
+                        ReplacementPolicy policy) {
+    delete dataCache;
+    dataCache = new Cache(size, ways, lineSize, policy,
+                          &stats->numDCacheAccesses, &stats->numDCacheMisses,
+                          &stats->numDCacheWriteBacks);
+    mmu.ModelDataCache(dataCache);
+    modelStalls = true;
+    StopShortcuts();
+}
+
+/// Costs are charged as instructions are fetched, so no shortcuts are
+/// taken either.  If `table` can be neither found nor read, every
+/// instruction keeps costing one tick.
+void
+Machine::ModelLatencies(const char *table) {
+    ASSERT(table);
+
+    if (!latencies) latencies = new LatencyTable;
+    if (!latencies->UsePreset(table)) latencies->Load(table);
+    modelStalls = true;
+    StopShortcuts();
+}
+
+void
+Machine::PrintProfile() const {
+    if (sequenceProfile) sequenceProfile->Print();
+    if (executionProfile) executionProfile->Print();
+    if (samplingProfile) samplingProfile->Print();
+}
+
+void
+Machine::StartMultiprocessing() {
+    batchTicks = false;
+    StopShortcuts();
+}
+
+void
+Machine::SaveCpuContext(CpuContext *cpu) const {
+    ASSERT(cpu);
+
+    memcpy(cpu->registers, registers, sizeof cpu->registers);
+    if (mmu.tlb) memcpy(cpu->tlb, mmu.tlb, sizeof cpu->tlb);
+    cpu->pageTable     = mmu.pageTable;
+    cpu->pageTableSize = mmu.pageTableSize;
+}
+
+/// The translation caches of the MMU belonged to the previous CPU.
+void
+Machine::RestoreCpuContext(const CpuContext &cpu) {
+    memcpy(registers, cpu.registers, sizeof registers);
+    if (mmu.tlb) memcpy(mmu.tlb, cpu.tlb, sizeof cpu.tlb);
+    mmu.pageTable     = cpu.pageTable;
+    mmu.pageTableSize = cpu.pageTableSize;
+    mmu.InvalidateTranslationCache();
+}
+
 void
 Machine::SetHandler(ExceptionType et, ExceptionHandler handler) {
     ASSERT(IsExceptionType(et));
@@ -20,8 +20,14 @@
 #ifndef NACHOS_MACHINE_MACHINE__HH
 #define NACHOS_MACHINE_MACHINE__HH
 
+#include ".binary_translator.hh"
+#include ".decode_cache.hh"
 #include ".exception_type.hh"
+#include ".execution_profile.hh"
+#include ".latency_table.hh"
 #include "mmu.hh"
+#include ".sampling_profile.hh"
+#include ".sequence_profile.hh"
 #include ".single_stepper.hh"
 #include "lib/utility.hh"
 
@@ -45,10 +51,18 @@ enum {
     NUM_TOTAL_REGS = 40
 };
 
-class Instruction;
-
 typedef void (*ExceptionHandler)(ExceptionType);
 
+/// What each CPU of a multiprocessor has of its own in the machine: its
+/// registers, its TLB and the page table it points to.  Physical memory is
+/// shared.
+struct CpuContext {
+    int registers[NUM_TOTAL_REGS];
+    TranslationEntry tlb[TLB_SIZE];
+    TranslationEntry *pageTable;
+    unsigned pageTableSize;
+};
+
 /// The following class defines the simulated host workstation hardware, as
 /// seen by user programs -- the CPU registers, main memory, etc.
 ///
@@ -66,7 +80,9 @@ class Machine {
 public:
 
     /// Initialize the simulation of the hardware for running user programs.
-    Machine(SingleStepper *st);
+    Machine(SingleStepper *st, unsigned numPhysPages, unsigned pageSize);
+
+    ~Machine();
 
     /// Routines callable by the Nachos kernel.
 
@@ -93,6 +109,59 @@ public:
     /// Print the user CPU and memory state.
     void DumpState();
 
+    /// Start counting the instruction sequences run by user programs.
+    void ProfileSequences();
+
+    /// Start counting the instructions, blocks and pages used by user
+    /// programs, naming code after the symbols in the COFF file
+    /// `symbolFile` (may be null).
+    void ProfileExecution(const char *symbolFile);
+
+    /// Start sampling what runs every `ticks` ticks, naming code after the
+    /// symbols in the COFF file `symbolFile` (may be null).
+    void ProfileSamples(unsigned ticks, const char *symbolFile);
+
+    /// Print the profiles gathered so far, if any.
+    void PrintProfile() const;
+
+    /// Model an instruction cache of `size` bytes, in lines of `lineSize`
+    /// bytes, with `ways` lines per set, and charge its misses to user
+    /// programs.
+    void ModelInstructionCache(unsigned size, unsigned ways,
+                               unsigned lineSize, ReplacementPolicy policy);
+
+    /// Same as `ModelInstructionCache`, for a cache of the data read and
+    /// written by user programs.
+    void ModelDataCache(unsigned size, unsigned ways, unsigned lineSize,
+                        ReplacementPolicy policy);
+
+    /// Charge user instructions the costs of a latency table: the preset
+    /// or the file named `table` (cf. `LatencyTable`).
+    void ModelLatencies(const char *table);
+
+    /// Save the registers, the page table in use, physical memory and the
+    /// simulated time into the file `fileName`.
+    void SaveCheckpoint(const char *fileName) const;
+
+    /// Go back to the state saved in the file `fileName`, storing the page
+    /// table saved with it into `pageTable` and `pageTableSize`.
+    ///
+    /// Return false, having changed nothing, if the file cannot be read or
+    /// was saved with a different memory size.
+    bool RestoreCheckpoint(const char *fileName,
+                           TranslationEntry **pageTable,
+                           unsigned *pageTableSize);
+
+    /// Be shared by several CPUs, which take turns after every tick.
+    ///
+    /// Ticks are then never batched, and every instruction is fetched.
+    void StartMultiprocessing();
+
+    /// Save the context of the CPU that is giving up the machine into
+    /// `cpu`, or load the context of the one taking it from `cpu`.
+    void SaveCpuContext(CpuContext *cpu) const;
+    void RestoreCpuContext(const CpuContext &cpu);
+
     /// Routines internal to the machine simulation -- DO NOT call these.
 
     /// Fetch one instruction of a user program.
@@ -103,9 +172,27 @@ public:
     /// Run a certain instruction of a user program.
     void ExecInstruction(const Instruction *instr);
 
+    /// Run a certain instruction together with the ones following it, if
+    /// they make up one of the sequences the simulator fuses.
+    ///
+    /// Return true if the whole sequence ran; every instruction but the
+    /// last one has then been ticked already.  Return false, having changed
+    /// nothing, if the instruction has to be run on its own.
+    bool ExecFused(const Instruction *instr);
+
+    /// Count the fetched instruction `instr` in the profiles.
+    void CountInstruction(const Instruction *instr);
+
     /// Do a pending delayed load (modifying a reg).
     void DelayedLoad(unsigned nextReg, int nextVal);
 
+    /// Advance the clock after running a user instruction.
+    void Tick();
+
+    /// Advance the clock by the ticks that the last instruction stalled
+    /// for, as told by the latency table and the modeled caches.
+    void Stall();
+
     /// Trap to the Nachos kernel, because of a system call or other
     /// exception.
     void RaiseException(ExceptionType et, unsigned badVAddr);
@@ -123,12 +210,67 @@ private:
                                    ///< provided object (may be a debugger)
                                    ///< after each simulated instruction.
 
+    bool batchTicks;  ///< Whether ticks before the next interrupt may skip
+                      ///< `Interrupt::OneTick`.
+
+    bool fuseSequences;  ///< Whether `ExecFused` may be used; not when
+                         ///< every instruction or access is traced.
+
+    unsigned fetchedAddr;  ///< Physical address of the last instruction
+                           ///< fetched.
+
     /// Private data structures.
     int registers[NUM_TOTAL_REGS];  ///< CPU registers, for executing user
                                     ///< programs.
 
     MMU mmu; ///< Memory management unit.
 
+    DecodeCache decodeCache;  ///< Already decoded instructions, by physical
+                              ///< address.
+
+#ifdef BINARY_TRANSLATION
+    BinaryTranslator *translator;  ///< Runs hot user code natively; null
+                                   ///< when every instruction must go
+                                   ///< through the interpreter.
+#endif
+
+    /// Stop using the shortcuts that skip fetching some instructions.
+    void StartProfiling();
+
+    /// Stop using the shortcuts that skip fetching some instructions or
+    /// accessing memory through `mmu`.
+    void StopShortcuts();
+
+    bool profiling;  ///< Whether there is any profile to count
+                     ///< instructions in.
+
+    SequenceProfile *sequenceProfile;  ///< Counts of the instruction
+                                       ///< sequences run; null unless
+                                       ///< asked for.
+
+    ExecutionProfile *executionProfile;  ///< Counts by address; null
+                                         ///< unless asked for.
+
+    SamplingProfile *samplingProfile;  ///< Stacks sampled by a timer; null
+                                       ///< unless asked for.
+
+    Cache *instructionCache;  ///< Models of the caches; null unless asked
+    Cache *dataCache;         ///< for.
+
+    LatencyTable *latencies;  ///< Costs of instructions; null unless asked
+                              ///< for.
+
+    bool modelStalls;  ///< Whether there is anything to stall for.
+
+    unsigned stallTicks;  ///< Ticks charged by `latencies` since the last
+                          ///< `Stall`.
+
+    bool branchTaken;  ///< Whether the last instruction was a branch or
+                       ///< jump that was taken, its delay slot coming next.
+
+    bool branched;  ///< Whether the next instruction to be fetched is the
+                    ///< target of a branch or jump, not yet charged for.
+
     ExceptionHandler handlers[NUM_EXCEPTION_TYPES];  ///< Exception handlers.
 };
 
@@ -20,6 +20,12 @@
 /// Note that the contents of the TLB are specific to an address space.
 /// If the address space changes, so does the contents of the TLB!
 ///
+/// Going through all of this on every access is slow, so once an access has
+/// been translated, the MMU remembers where the page is in `mainMemory`, and
+/// later accesses to the same page only have to compare the page number.
+/// Whoever changes the translation tables must tell the MMU, with
+/// `InvalidateTranslationCache`.
+///
 /// DO NOT CHANGE -- part of the machine emulation
 ///
 /// Copyright (c) 1992-1993 The Regents of the University of California.
@@ -30,22 +36,41 @@
 #include "mmu.hh"
 #include ".endianness.hh"
 
-MMU::MMU() {
-    mainMemory = new char [MEMORY_SIZE];
-    for (unsigned i = 0; i < MEMORY_SIZE; i++) mainMemory[i] = 0;
-
-#ifdef USE_TLB
-    tlb = new TranslationEntry[TLB_SIZE];
-    for (unsigned i = 0; i < TLB_SIZE; i++) tlb[i].valid = false;
-    pageTable = nullptr;
-#else  // Use linear page table.
-    tlb = nullptr;
-    pageTable = nullptr;
-#endif
+#include <limits.h>
+
+/// Physical memory is allocated zero-filled, and the host only provides it
+/// as it gets used, so that large memories do not cost anything up front.
+template <class Policy>
+BasicMMU<Policy>::BasicMMU(unsigned physPages, unsigned bytesPerPage) {
+    ASSERT(physPages > 0);
+    ASSERT(bytesPerPage >= 4 && (bytesPerPage & (bytesPerPage - 1)) == 0);
+    ASSERT(physPages <= UINT_MAX / bytesPerPage);
+
+    pageSize     = bytesPerPage;
+    numPhysPages = physPages;
+    memorySize   = physPages * bytesPerPage;
+    for (pageShift = 0; 1U << pageShift < pageSize; pageShift++)
+        ;
+
+    mainMemory = AllocZeroedArray(memorySize);
+
+    if (Policy::USES_TLB) {
+        tlb = new TranslationEntry[TLB_SIZE];
+        for (unsigned i = 0; i < TLB_SIZE; i++) tlb[i].valid = false;
+    } else  // Use linear page table.
+        tlb = nullptr;
+    pageTable     = nullptr;
+    pageTableSize = 0;
+
+    // The tracing of memory accesses would otherwise skip cached ones.
+    useTranslationCache = !debug.IsEnabled('A') && !debug.IsEnabled('a');
+    InvalidateTranslationCache();
+    dataCache = nullptr;
 }
 
-MMU::~MMU() {
-    delete [] mainMemory;
+template <class Policy>
+BasicMMU<Policy>::~BasicMMU() {
+    DeallocZeroedArray(mainMemory, memorySize);
     if (tlb) delete [] tlb;
 }
 
@@ -58,29 +83,38 @@ MMU::~MMU() {
 /// * `addr` is the virtual address to read from.
 /// * `size` is the number of bytes to read (1, 2, or 4).
 /// * `value` is the place to write the result.
+template <class Policy>
 ExceptionType
-MMU::ReadMem(unsigned addr, unsigned size, int *value) {
-    DEBUG('A', "Reading VA 0x%X, size %u.\n", addr, size);
+BasicMMU<Policy>::ReadMem(unsigned addr, unsigned size, int *value) {
     ASSERT(value);
 
-    unsigned physicalAddress;
-    ExceptionType e = Translate(addr, &physicalAddress, size, false);
-    if (e != NO_EXCEPTION) return e;
+    char *host = LookUp(readCache, addr, size);
+    if (host == nullptr) {
+        DEBUG('A', "Reading VA 0x%X, size %u.\n", addr, size);
+
+        unsigned physicalAddress;
+        ExceptionType e = Translate(addr, &physicalAddress, size, false);
+        if (e != NO_EXCEPTION) return e;
+
+        Remember(readCache, addr, physicalAddress);
+        host = &mainMemory[physicalAddress];
+    }
+    if (dataCache) dataCache->Access(host - mainMemory, false);
 
     int data;
     switch (size) {
         case 1:
-            data = mainMemory[physicalAddress];
+            data = *host;
             *value = data;
             break;
 
         case 2:
-            data = *(unsigned short *) &mainMemory[physicalAddress];
+            data = *(unsigned short *) host;
             *value = ShortToHost(data);
             break;
 
         case 4:
-            data = *(unsigned *) &mainMemory[physicalAddress];
+            data = *(unsigned *) host;
             *value = WordToHost(data);
             break;
 
@@ -89,6 +123,7 @@ MMU::ReadMem(unsigned addr, unsigned size, int *value) {
     }
 
     DEBUG('A', "\tValue read: %X.\n", *value);
+    TRACE(TRACE_READ, addr, size, *value);
     return NO_EXCEPTION;
 }
 
@@ -101,74 +136,104 @@ MMU::ReadMem(unsigned addr, unsigned size, int *value) {
 /// * `addr` is the virtual address to write to.
 /// * `size` is the number of bytes to be written (1, 2, or 4).
 /// * `value` is the data to be written.
+template <class Policy>
 ExceptionType
-MMU::WriteMem(unsigned addr, unsigned size, int value) {
-    DEBUG('A', "Writing VA 0x%X, size %u, value %d.\n", addr, size, value);
+BasicMMU<Policy>::WriteMem(unsigned addr, unsigned size, int value) {
+    char *host = LookUp(writeCache, addr, size);
+    if (host == nullptr) {
+        DEBUG('A', "Writing VA 0x%X, size %u, value %d.\n", addr, size, value);
 
-    unsigned physicalAddress;
-    ExceptionType e = Translate(addr, &physicalAddress, size, true);
-    if (e != NO_EXCEPTION) return e;
+        unsigned physicalAddress;
+        ExceptionType e = Translate(addr, &physicalAddress, size, true);
+        if (e != NO_EXCEPTION) return e;
+
+        Remember(writeCache, addr, physicalAddress);
+        host = &mainMemory[physicalAddress];
+    }
+    if (dataCache) dataCache->Access(host - mainMemory, true);
 
     switch (size) {
       case 1:
-          mainMemory[physicalAddress] = (unsigned char) (value & 0xFF);
+          *host = (unsigned char) (value & 0xFF);
           break;
 
       case 2:
-          *(unsigned short *) &mainMemory[physicalAddress]
+          *(unsigned short *) host
             = ShortToMachine((unsigned short) (value & 0xFFFF));
           break;
 
       case 4:
-          *(unsigned *) &mainMemory[physicalAddress] = WordToMachine((unsigned) value);
+          *(unsigned *) host = WordToMachine((unsigned) value);
           break;
 
       default:
           ASSERT(false);
     }
 
+    TRACE(TRACE_WRITE, addr, size, value);
     return NO_EXCEPTION;
 }
 
+template <class Policy>
 ExceptionType
-MMU::RetrievePageEntry(unsigned vpn, TranslationEntry **entry) const {
+BasicMMU<Policy>::PeekWord(unsigned addr, int *value) const {
+    ASSERT(value);
+
+    if (addr & 0x3) return ADDRESS_ERROR_EXCEPTION;
+
+    TranslationEntry *entry;
+    ExceptionType e = Policy::RetrievePageEntry(*this, addr >> pageShift,
+                                                &entry);
+    if (e != NO_EXCEPTION) return e;
+    if (entry->physicalPage >= numPhysPages) return BUS_ERROR_EXCEPTION;
+
+    unsigned physAddr = entry->physicalPage * pageSize
+                          + (addr & (pageSize - 1));
+    *value = WordToHost(*(unsigned *) &mainMemory[physAddr]);
+    return NO_EXCEPTION;
+}
+
+ExceptionType
+PageTablePolicy::RetrievePageEntry(const TranslationTables &tables,
+                                   unsigned vpn, TranslationEntry **entry) {
     ASSERT(entry);
 
-    if (!tlb) {
-        // Use a page table; `vpn` is an index in the table.
-
-        if (vpn >= pageTableSize) {
-            DEBUG_CONT_ERROR('A', "virtual page # %u too large for page table size %u!\n",
-                       vpn, pageTableSize);
-            return ADDRESS_ERROR_EXCEPTION;
-        } else if (!pageTable[vpn].valid) {
-            DEBUG_CONT_ERROR('A', "virtual page # %u too large for page table size %u!\n",
-                       vpn, pageTableSize);
-            return PAGE_FAULT_EXCEPTION;
-        }
+    // `vpn` is an index in the table.
 
-        *entry = &pageTable[vpn];
-        return NO_EXCEPTION;
-    } else {
-        // Use the TLB.
-
-        unsigned i;
-        for (i = 0; i < TLB_SIZE; i++)
-            if (tlb[i].valid && tlb[i].virtualPage == vpn) {
-                *entry = &tlb[i];  // FOUND!
-                return NO_EXCEPTION;
-            }
-
-        // Not found.
-        DEBUG_CONT_ERROR('A', "no valid TLB entry found for this virtual page!\n");
-        return PAGE_FAULT_EXCEPTION;  // Really, this is a TLB fault, the
-                                      // page may be in memory, but not in
-                                      // the TLB.
+    if (vpn >= tables.pageTableSize) {
+        DEBUG_CONT_ERROR('A', "virtual page # %u too large for page table size %u!\n",
+                   vpn, tables.pageTableSize);
+        return ADDRESS_ERROR_EXCEPTION;
+    } else if (!tables.pageTable[vpn].valid) {
+        DEBUG_CONT_ERROR('A', "virtual page # %u too large for page table size %u!\n",
+                   vpn, tables.pageTableSize);
+        return PAGE_FAULT_EXCEPTION;
     }
+
+    *entry = &tables.pageTable[vpn];
+    return NO_EXCEPTION;
+}
+
+ExceptionType
+TlbPolicy::RetrievePageEntry(const TranslationTables &tables,
+                             unsigned vpn, TranslationEntry **entry) {
+    ASSERT(entry);
+
+    TranslationEntry *tlb = tables.tlb;
+    for (unsigned i = 0; i < TLB_SIZE; i++)
+        if (tlb[i].valid && tlb[i].virtualPage == vpn) {
+            *entry = &tlb[i];  // FOUND!
+            return NO_EXCEPTION;
+        }
+
+    // Not found.
+    DEBUG_CONT_ERROR('A', "no valid TLB entry found for this virtual page!\n");
+    return PAGE_FAULT_EXCEPTION;  // Really, this is a TLB fault, the page
+                                  // may be in memory, but not in the TLB.
 }
 
 /// Translate a virtual address into a physical address, using
-/// either a page table or a TLB.
+/// either a page table or a TLB, as `Policy` tells.
 ///
 /// Check for alignment and all sorts of other errors, and if everything is
 /// ok, set the use/dirty bits in the translation table entry, and store the
@@ -179,12 +244,12 @@ MMU::RetrievePageEntry(unsigned vpn, TranslationEntry **entry) const {
 /// * `physAddr" is the place to store the physical address.
 /// * `size" is the amount of memory being read or written.
 /// * `writing` -- if true, check the “read-only” bit in the TLB.
+template <class Policy>
 ExceptionType
-MMU::Translate(unsigned virtAddr, unsigned *physAddr, unsigned size, bool writing) {
+BasicMMU<Policy>::Translate(unsigned virtAddr, unsigned *physAddr,
+                            unsigned size, bool writing) {
     DEBUG('A', "\tTranslate: ");
 
-    // We must have either a TLB or a page table, but not both!
-    ASSERT((!tlb) != (!pageTable));
     ASSERT(physAddr);
 
     // Check for alignment errors.
@@ -195,11 +260,11 @@ MMU::Translate(unsigned virtAddr, unsigned *physAddr, unsigned size, bool writin
 
     // Calculate the virtual page number, and offset within the page,
     // from the virtual address.
-    unsigned vpn    = (unsigned) virtAddr / PAGE_SIZE;
-    unsigned offset = (unsigned) virtAddr % PAGE_SIZE;
+    unsigned vpn    = virtAddr >> pageShift;
+    unsigned offset = virtAddr & (pageSize - 1);
 
     TranslationEntry *entry;
-    ExceptionType exception = RetrievePageEntry(vpn, &entry);
+    ExceptionType exception = Policy::RetrievePageEntry(*this, vpn, &entry);
     if (exception != NO_EXCEPTION) return exception;
 
     if (entry->readOnly && writing) {  // Trying to write to a read-only
@@ -212,15 +277,16 @@ MMU::Translate(unsigned virtAddr, unsigned *physAddr, unsigned size, bool writin
 
     // If the `pageFrame` is too big, there is something really wrong!  An
     // invalid translation was loaded into the page table or TLB.
-    if (pageFrame >= NUM_PHYS_PAGES) {
-        DEBUG_CONT_ERROR('A', "frame %u > %u!\n", pageFrame, NUM_PHYS_PAGES);
+    if (pageFrame >= numPhysPages) {
+        DEBUG_CONT_ERROR('A', "frame %u > %u!\n", pageFrame, numPhysPages);
         return BUS_ERROR_EXCEPTION;
     }
 
-    *physAddr = pageFrame * PAGE_SIZE + offset;
+    *physAddr = pageFrame * pageSize + offset;
 
     DEBUG_CONT('A', "physical address 0x%X.\n", *physAddr);
-    ASSERT(*physAddr >= 0 && *physAddr + size <= MEMORY_SIZE);
+    TRACE(TRACE_TRANSLATE, virtAddr, *physAddr, writing);
+    ASSERT(*physAddr >= 0 && *physAddr + size <= memorySize);
 
     // Set the `use` and `dirty` flags.
     entry->use = true;
@@ -232,8 +298,54 @@ MMU::Translate(unsigned virtAddr, unsigned *physAddr, unsigned size, bool writin
     return NO_EXCEPTION;
 }
 
+template <class Policy>
+void
+BasicMMU<Policy>::InvalidateTranslationCache() {
+    for (unsigned i = 0; i < TRANSLATION_CACHE_SIZE; i++) {
+        readCache[i].vpn  = UINT_MAX;
+        writeCache[i].vpn = UINT_MAX;
+    }
+}
+
+template <class Policy>
 void
-MMU::PrintTLB() const {
+BasicMMU<Policy>::ModelDataCache(Cache *cache) {
+    dataCache = cache;
+}
+
+/// An unused entry never matches, since no virtual page number reaches
+/// `UINT_MAX`.  `size` is a power of two, so the alignment check is a
+/// mask.
+template <class Policy>
+inline char *
+BasicMMU<Policy>::LookUp(const CachedTranslation *cache,
+            unsigned addr, unsigned size) const {
+    unsigned vpn = addr >> pageShift;
+    const CachedTranslation &entry = cache[vpn % TRANSLATION_CACHE_SIZE];
+
+    if (entry.vpn != vpn || (addr & (size - 1)) != 0) return nullptr;
+    return entry.frame + (addr & (pageSize - 1));
+}
+
+/// `Translate` has just set the `use` bit of the page (and the `dirty` bit,
+/// when writing), so skipping it for later accesses to the same page leaves
+/// the translation tables exactly as they would have been.
+template <class Policy>
+void
+BasicMMU<Policy>::Remember(CachedTranslation *cache,
+                           unsigned addr, unsigned physAddr) {
+    if (!useTranslationCache) return;
+
+    unsigned vpn = addr >> pageShift;
+    CachedTranslation &entry = cache[vpn % TRANSLATION_CACHE_SIZE];
+
+    entry.vpn   = vpn;
+    entry.frame = &mainMemory[physAddr - (addr & (pageSize - 1))];
+}
+
+template <class Policy>
+void
+BasicMMU<Policy>::PrintTLB() const {
     printf("TLB Content:\n");
     for (unsigned i = 0; i < TLB_SIZE; i++)
         if (tlb[i].valid)
@@ -241,3 +353,6 @@ MMU::PrintTLB() const {
                     i, tlb[i].virtualPage, tlb[i].physicalPage, tlb[i].valid,
                     tlb[i].readOnly, tlb[i].use, tlb[i].dirty);
 }
+
+template class BasicMMU<PageTablePolicy>;
+template class BasicMMU<TlbPolicy>;
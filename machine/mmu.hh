@@ -8,28 +8,104 @@
 #ifndef NACHOS_MACHINE_MMU__HH
 #define NACHOS_MACHINE_MMU__HH
 
+#include ".cache.hh"
 #include ".exception_type.hh"
 #include "disk.hh"
 #include "translation_entry.hh"
 
 /// Definitions related to the size, and format of user memory.
+///
+/// The size of a page and the number of pages can be changed when starting
+/// Nachos (see `Initialize` in `system.cc`); these are the defaults.
 
-const unsigned PAGE_SIZE = SECTOR_SIZE;  ///< Set the page size equal to the
-                                         ///< disk sector size, for
-                                         ///< simplicity.
-const unsigned NUM_PHYS_PAGES = 32;
-const unsigned MEMORY_SIZE = NUM_PHYS_PAGES * PAGE_SIZE;
+const unsigned DEFAULT_PAGE_SIZE = SECTOR_SIZE;  ///< Set the page size equal
+                                                 ///< to the disk sector
+                                                 ///< size, for simplicity.
+const unsigned DEFAULT_NUM_PHYS_PAGES = 32;
 const unsigned TLB_SIZE = 4;  ///< if there is a TLB, make it small.
 
-/// This class simulates an MMU (memory management unit) that can use either
-/// page tables or a TLB.
-class MMU {
+/// The translation tables that the kernel sets up for the MMU.
+///
+/// NOTE: the hardware translation of virtual addresses in the user program
+/// to physical addresses (relative to the beginning of `mainMemory`) can be
+/// controlled by one of:
+/// * a traditional linear page table;
+/// * a software-loaded translation lookaside buffer (tlb) -- a cache of
+///   mappings of virtual page #'s to physical page #'s.
+///
+/// Which one is used is fixed when Nachos is built (see `MMU` below).  With
+/// a linear page table, `tlb` is null.  With a TLB, the Nachos kernel is
+/// responsible for managing the contents of the TLB, and `pageTable` is
+/// ignored by the hardware.  But the kernel can use any data structure it
+/// wants (eg, segmented paging) for handling TLB cache misses.
+///
+/// For simplicity, both the page table pointer and the TLB pointer are
+/// public.  However, while there can be multiple page tables (one per
+/// address space, stored in memory), there is only one TLB (implemented in
+/// hardware).  Thus the TLB pointer should be considered as *read-only*,
+/// although the contents of the TLB are free to be modified by the kernel
+/// software.
+///
+/// The MMU keeps the last translations it has done in a cache of its own
+/// (see `BasicMMU::InvalidateTranslationCache`), which the kernel has to
+/// flush after changing any of these.
+class TranslationTables {
 public:
-    // Initialize the MMU subsystem.
-    MMU();
+
+    /// This pointer should be considered “read-only” to Nachos kernel code.
+    TranslationEntry *tlb;
+
+    TranslationEntry *pageTable;
+    unsigned pageTableSize;
+};
+
+/// Translation policies.
+///
+/// A policy tells the MMU how to find the translation entry of a virtual
+/// page, with:
+/// * `USES_TLB`, whether the MMU has a TLB;
+/// * `RetrievePageEntry`, which looks up the entry for `vpn` in `tables`,
+///   storing it in `entry`, or returns the exception to raise.
+///
+/// Another structure, such as a multi-level page table, only needs one more
+/// policy, instantiated at the end of `mmu.cc`.
+
+/// Look up translations in a linear page table, indexed by virtual page
+/// number.
+class PageTablePolicy {
+public:
+    static const bool USES_TLB = false;
+
+    static ExceptionType RetrievePageEntry(const TranslationTables &tables,
+                                           unsigned vpn,
+                                           TranslationEntry **entry);
+};
+
+/// Look up translations in the TLB; the kernel handles the misses.
+class TlbPolicy {
+public:
+    static const bool USES_TLB = true;
+
+    static ExceptionType RetrievePageEntry(const TranslationTables &tables,
+                                           unsigned vpn,
+                                           TranslationEntry **entry);
+};
+
+/// This class simulates an MMU (memory management unit) that finds
+/// translations as told by `Policy`.
+///
+/// The choice is made at compile time, so the translation of every access
+/// goes straight to the right table.
+template <class Policy>
+class BasicMMU : public TranslationTables {
+public:
+    // Initialize the MMU subsystem, with `physPages` pages of physical
+    // memory, of `bytesPerPage` bytes each.  The page size must be a power
+    // of two.
+    BasicMMU(unsigned physPages, unsigned bytesPerPage);
 
     // Deallocate data structures.
-    ~MMU();
+    ~BasicMMU();
 
     /// Read or write 1, 2, or 4 bytes of virtual memory (at `addr`).  Return
     /// false if a correct translation could not be found.
@@ -38,55 +114,107 @@ public:
 
     ExceptionType WriteMem(unsigned addr, unsigned size, int value);
 
+    /// Read the word at virtual address `addr` on behalf of a tool watching
+    /// the program, such as the sampling profiler.
+    ///
+    /// Unlike `ReadMem`, it leaves the `use` bit of the page and the
+    /// translation caches alone, so neither the program nor the kernel can
+    /// tell.
+    ExceptionType PeekWord(unsigned addr, int *value) const;
+
     /// Data structures -- all of these are accessible to Nachos kernel code.
     /// “Public” for convenience.
     ///
     /// Note that *all* communication between the user program and the kernel
-    /// are in terms of these data structures, along with the already
-    /// declared methods.
+    /// are in terms of these data structures (and those of
+    /// `TranslationTables`), along with the already declared methods.
 
     /// Physical memory to store user program, code and data, while executing.
     char *mainMemory;
 
-    /// NOTE: the hardware translation of virtual addresses in the user
-    /// program to physical addresses (relative to the beginning of
-    /// `mainMemory`) can be controlled by one of:
-    /// * a traditional linear page table;
-    /// * a software-loaded translation lookaside buffer (tlb) -- a cache of
-    ///   mappings of virtual page #'s to physical page #'s.
-    ///
-    /// If `tlb` is null, the linear page table is used.
-    /// If `tlb` is non-null, the Nachos kernel is responsible for managing
-    /// the contents of the TLB.  But the kernel can use any data structure
-    /// it wants (eg, segmented paging) for handling TLB cache misses.
-    ///
-    /// For simplicity, both the page table pointer and the TLB pointer are
-    /// public.  However, while there can be multiple page tables (one per
-    /// address space, stored in memory), there is only one TLB (implemented
-    /// in hardware).  Thus the TLB pointer should be considered as
-    /// *read-only*, although the contents of the TLB are free to be modified
-    /// by the kernel software.
+    unsigned GetPageSize() const {
+        return pageSize;
+    }
 
-    /// This pointer should be considered “read-only” to Nachos kernel code.
-    TranslationEntry *tlb;
+    unsigned GetNumPhysPages() const {
+        return numPhysPages;
+    }
 
-    TranslationEntry *pageTable;
-    unsigned pageTableSize;
+    /// Size of `mainMemory`, in bytes.
+    unsigned GetMemorySize() const {
+        return memorySize;
+    }
 
     void PrintTLB() const;
 
-private:
+    /// Forget every translation remembered by `ReadMem` and `WriteMem`.
+    ///
+    /// Must be called whenever `pageTable` or `pageTableSize` change (for
+    /// example, on a context switch), and whenever an entry of the page
+    /// table or the TLB is modified: made valid or invalid, moved to
+    /// another frame, made read-only, or has its `use` or `dirty` bits
+    /// cleared.
+    void InvalidateTranslationCache();
 
-    /// Retrieve a page entry either from a page table or the TLB.
-    ExceptionType RetrievePageEntry(unsigned vpn, TranslationEntry **entry) const;
+    /// Have every access by `ReadMem` and `WriteMem` go through `cache`
+    /// too, which the caller keeps owning (null to stop).
+    void ModelDataCache(Cache *cache);
 
     /// Translate an address, and check for alignment.
     ///
     /// Set the use and dirty bits in the translation entry appropriately,
     /// and return an exception code if the translation could not be
     /// completed.
+    ///
+    /// Public so that instruction fetch can find the physical address of an
+    /// instruction, which is what the decoded instruction cache is keyed
+    /// by.
     ExceptionType Translate(unsigned virtAddr, unsigned *physAddr,
                             unsigned size, bool writing);
+
+private:
+
+    unsigned pageSize;
+    unsigned pageShift;  ///< Base 2 logarithm of `pageSize`.
+    unsigned numPhysPages;
+    unsigned memorySize;
+
+    /// Number of entries in each translation cache.
+    static const unsigned TRANSLATION_CACHE_SIZE = 64;
+
+    /// A virtual page, together with where its frame is in `mainMemory`.
+    struct CachedTranslation {
+        unsigned vpn;  ///< `UINT_MAX` if the entry is unused.
+        char *frame;
+    };
+
+    /// Return where the `size` bytes at virtual address `addr` are in
+    /// `mainMemory`, if `cache` holds the translation of their page and they
+    /// are properly aligned; null otherwise.
+    char *LookUp(const CachedTranslation *cache,
+                 unsigned addr, unsigned size) const;
+
+    /// Remember that `addr` was translated into `physAddr`.
+    void Remember(CachedTranslation *cache, unsigned addr, unsigned physAddr);
+
+    /// Successful translations, indexed by virtual page number modulo
+    /// `TRANSLATION_CACHE_SIZE`; separate for reading and writing, since a
+    /// page that can be read may still be read-only.
+    CachedTranslation readCache[TRANSLATION_CACHE_SIZE];
+    CachedTranslation writeCache[TRANSLATION_CACHE_SIZE];
+
+    /// The caches are not used while tracing memory accesses.
+    bool useTranslationCache;
+
+    Cache *dataCache;  ///< Model of the data cache; null unless asked for.
 };
 
+/// The MMU of the simulated machine: it uses a TLB if Nachos is built with
+/// *USE_TLB*, and a linear page table otherwise.
+#ifdef USE_TLB
+typedef BasicMMU<TlbPolicy> MMU;
+#else
+typedef BasicMMU<PageTablePolicy> MMU;
+#endif
+
 #endif
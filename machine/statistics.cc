@@ -16,21 +16,23 @@ Statistics::Statistics() {
     numDiskReads = numDiskWrites = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
     numPageFaults = numPacketsSent = numPacketsRecvd = 0;
-#ifdef DFS_TICKS_FIX
-    tickResets = 0;
-#endif
+    numICacheAccesses = numICacheMisses = 0;
+    numDCacheAccesses = numDCacheMisses = numDCacheWriteBacks = 0;
+    for (unsigned i = 0; i < NUM_FEEDBACK_LEVELS; i++)
+        numFeedbackDispatches[i] = maxFeedbackReady[i] = 0;
+}
+
+/// Return the percentage of `accesses` that did not miss.
+static double
+HitRate(unsigned long long accesses, unsigned long long misses) {
+    return 100.0 * (accesses - misses) / accesses;
 }
 
 /// Print performance metrics, when we have finished everything at system
 /// shutdown.
 void
 Statistics::Print() {
-#ifdef DFS_TICKS_FIX
-    if (tickResets != 0)
-        printf("WARNING: the tick counter was reset %lu times; the following"
-               " statistics may be invalid.\n\n", tickResets);
-#endif
-    printf("Ticks: total %u, idle %u, system %u, user %u.\n",
+    printf("Ticks: total %llu, idle %llu, system %llu, user %llu.\n",
            totalTicks, idleTicks, systemTicks, userTicks);
     printf("Disk I/O: reads %u, writes %u.\n", numDiskReads, numDiskWrites);
     printf("Console I/O: reads %u, writes %u.\n",
@@ -38,4 +40,17 @@ Statistics::Print() {
     printf("Paging: faults %u.\n", numPageFaults);
     printf("Network I/O: packets received %u, sent %u.\n",
            numPacketsRecvd, numPacketsSent);
+    if (numICacheAccesses > 0)
+        printf("Instruction cache: accesses %llu, misses %llu, "
+               "hit rate %.2f%%.\n", numICacheAccesses, numICacheMisses,
+               HitRate(numICacheAccesses, numICacheMisses));
+    if (numDCacheAccesses > 0)
+        printf("Data cache: accesses %llu, misses %llu, write backs %llu, "
+               "hit rate %.2f%%.\n", numDCacheAccesses, numDCacheMisses,
+               numDCacheWriteBacks,
+               HitRate(numDCacheAccesses, numDCacheMisses));
+    for (unsigned i = 0; i < NUM_FEEDBACK_LEVELS; i++)
+        if (numFeedbackDispatches[i] > 0)
+            printf("Feedback level %u: dispatches %u, most ready %u.\n",
+                   i, numFeedbackDispatches[i], maxFeedbackReady[i]);
 }
@@ -10,6 +10,10 @@
 #ifndef NACHOS_MACHINE_STATS__HH
 #define NACHOS_MACHINE_STATS__HH
 
+/// Levels of the multilevel feedback queue of the scheduler (cf.
+/// `Scheduler::UseFeedback`), whose ready lists are counted.
+const unsigned NUM_FEEDBACK_LEVELS = 4;
+
 /// The following class defines the statistics that are to be kept about
 /// Nachos behavior -- how much time (ticks) elapsed, how many user
 /// instructions executed, etc.
@@ -19,17 +23,20 @@ class Statistics {
 public:
 
     /// Total time running Nachos.
-    unsigned totalTicks;
+    ///
+    /// Simulated time is kept in 64 bits, so that it never wraps around,
+    /// however long the simulation runs.
+    unsigned long long totalTicks;
 
     /// Time spent idle (no threads to run).
-    unsigned idleTicks;
+    unsigned long long idleTicks;
 
     /// Time spent executing system code.
-    unsigned systemTicks;
+    unsigned long long systemTicks;
 
     /// Time spent executing user code (this is also equal to # of user
     /// instructions executed).
-    unsigned userTicks;
+    unsigned long long userTicks;
 
     /// Number of disk read requests.
     unsigned numDiskReads;
@@ -52,10 +59,22 @@ public:
     /// Number of packets received over the network.
     unsigned numPacketsRecvd;
 
-#ifdef DFS_TICKS_FIX
-    /// Number of times the tick count gets reset.
-    unsigned long tickResets;
-#endif
+    /// Accesses to the instruction cache, and how many of them missed;
+    /// only counted when the cache is modeled.
+    unsigned long long numICacheAccesses;
+    unsigned long long numICacheMisses;
+
+    /// Accesses to the data cache, how many of them missed, and how many
+    /// dirty lines were written back.
+    unsigned long long numDCacheAccesses;
+    unsigned long long numDCacheMisses;
+    unsigned long long numDCacheWriteBacks;
+
+    /// Threads dispatched from each level of the multilevel feedback queue,
+    /// and the most threads ever ready at each level at once; only counted
+    /// when scheduling that way.
+    unsigned numFeedbackDispatches[NUM_FEEDBACK_LEVELS];
+    unsigned maxFeedbackReady[NUM_FEEDBACK_LEVELS];
 
     /// Initialize everything to zero.
     Statistics();
@@ -80,5 +99,6 @@ const unsigned SEEK_TIME     = 500; ///< Time disk takes to seek past one track.
 const unsigned CONSOLE_TIME  = 100; ///< Time to read or write one character.
 const unsigned NETWORK_TIME  = 100; ///< Time to send or receive one packet.
 const unsigned TIMER_TICKS   = 100; ///< (Average) time between timer interrupts.
+const unsigned CACHE_MISS_TIME = 10; ///< Time to fill or write back one line.
 
 #endif
@@ -41,11 +41,28 @@ TimerHandler(void *arg) {
 ///   instead of fixed, intervals.
 Timer::Timer(VoidFunctionPtr timerHandler, void *callArg, bool doRandom) {
     randomize = doRandom;
+    period    = TIMER_TICKS;
+    type      = TIMER_INT;
     handler   = timerHandler;
     arg       = callArg;
 
     // Schedule the first interrupt from the timer device.
-    interrupt->Schedule(TimerHandler, this, TimeOfNextInterrupt(), TIMER_INT);
+    interrupt->Schedule(TimerHandler, this, TimeOfNextInterrupt(), type);
+}
+
+/// A fixed period never calls `Random`, so such a timer does not change the
+/// delays drawn by a randomized one.
+Timer::Timer(VoidFunctionPtr timerHandler, void *callArg, unsigned ticks,
+             IntType kind) {
+    ASSERT(ticks > 0);
+
+    randomize = false;
+    period    = ticks;
+    type      = kind;
+    handler   = timerHandler;
+    arg       = callArg;
+
+    interrupt->Schedule(TimerHandler, this, TimeOfNextInterrupt(), type);
 }
 
 /// Routine to simulate the interrupt generated by the hardware timer device.
@@ -54,7 +71,7 @@ Timer::Timer(VoidFunctionPtr timerHandler, void *callArg, bool doRandom) {
 void
 Timer::TimerExpired() {
     // Schedule the next timer device interrupt.
-    interrupt->Schedule(TimerHandler, this, TimeOfNextInterrupt(), TIMER_INT);
+    interrupt->Schedule(TimerHandler, this, TimeOfNextInterrupt(), type);
 
     // Invoke the Nachos interrupt handler for this device.
     (*handler)(arg);
@@ -62,9 +79,19 @@ Timer::TimerExpired() {
 
 /// Return when the hardware timer device will next cause an interrupt.
 ///
-/// If `randomize` is turned on, make it a (pseudo-)random delay.
+/// If `randomize` is turned on, make it a (pseudo-)random delay.  Random
+/// delays are also what `eventLog` records and replays.
 int
 Timer::TimeOfNextInterrupt() {
-    if (randomize) return 1 + Random() % (TIMER_TICKS * 2);
-    else return TIMER_TICKS;
+    if (!randomize) return period;
+
+    int delay;
+    if (eventLog && eventLog->IsReplaying()
+          && eventLog->Replay(TIMER_EVENT, &delay, sizeof delay))
+        return delay;
+
+    delay = 1 + Random() % (TIMER_TICKS * 2);
+    if (eventLog && !eventLog->IsReplaying())
+        eventLog->Record(TIMER_EVENT, &delay, sizeof delay);
+    return delay;
 }
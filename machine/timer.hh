@@ -20,6 +20,7 @@
 #ifndef NACHOS_MACHINE_TIMER__HH
 #define NACHOS_MACHINE_TIMER__HH
 
+#include "interrupt.hh"
 #include "lib/utility.hh"
 
 /// The following class defines a hardware timer.
@@ -30,6 +31,11 @@ public:
     /// every time slice.
     Timer(VoidFunctionPtr timerHandler, void *callArg, bool doRandom);
 
+    /// Initialize a timer that calls `timerHandler` exactly every `ticks`
+    /// ticks, raising interrupts of type `kind`.
+    Timer(VoidFunctionPtr timerHandler, void *callArg, unsigned ticks,
+          IntType kind);
+
     ~Timer() {}
 
     /// Internal routines to the timer emulation -- DO NOT call these.
@@ -42,6 +48,8 @@ public:
 
 private:
     bool randomize;  ///< Set if we need to use a random timeout delay.
+    unsigned period;  ///< Delay between interrupts, if not random.
+    IntType type;  ///< Type of the interrupts raised.
     VoidFunctionPtr handler;  ///< Timer interrupt handler.
     void *arg;  ///< Argument to pass to interrupt handler.
 
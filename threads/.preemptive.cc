@@ -141,9 +141,12 @@ ContextSwitch(void) {
 
     inContextSwitch = true;
 
-    // Make a context switch if interrupts are enabled.
+    // Make a context switch if interrupts are enabled.  Only then is the
+    // slice over for the feedback queue: with interrupts disabled, the
+    // scheduler may be half way through moving `currentThread`.
     if (interrupt->GetLevel() == INT_ON) {
         inContextSwitch = false;
+        scheduler->SliceExpired(currentThread);
         currentThread->Yield();
     } else {
         interrupt->YieldOnReturn();
@@ -1,24 +1,53 @@
 #include "synch.hh"
 
-Condition::Condition(const char *debugName, Lock *conditionLock)
-{}
+/// Initialize a condition variable, with no thread waiting on it.
+///
+/// * `debugName` is an arbitrary name, useful for debugging.
+/// * `conditionLock` is the lock that must be held to use it.
+Condition::Condition(const char *debugName, Lock *conditionLock) {
+    ASSERT(conditionLock);
 
-Condition::~Condition()
-{}
+    name    = debugName;
+    lock    = conditionLock;
+    waiters = new List<Semaphore *>;
+}
+
+/// Assume no one is still waiting on the condition variable!
+Condition::~Condition() {
+    delete waiters;
+}
 
 const char *
 Condition::GetName() const {
     return name;
 }
 
+/// The thread is put among the waiters before the lock is released, so
+/// that a `Signal` made as soon as it is released is not lost.
 void
-Condition::Wait()
-{}
+Condition::Wait() {
+    ASSERT(lock->IsHeldByCurrentThread());
+
+    Semaphore *semaphore = new Semaphore(name, 0);
+    waiters->Append(semaphore);
+    lock->Release();
+    semaphore->P();
+    delete semaphore;
+    lock->Acquire();
+}
 
 void
-Condition::Signal()
-{}
+Condition::Signal() {
+    ASSERT(lock->IsHeldByCurrentThread());
+
+    Semaphore *semaphore = waiters->Pop();
+    if (semaphore) semaphore->V();
+}
 
 void
-Condition::Broadcast()
-{}
+Condition::Broadcast() {
+    ASSERT(lock->IsHeldByCurrentThread());
+
+    while (!waiters->IsEmpty())
+        waiters->Pop()->V();
+}
@@ -55,5 +55,8 @@ private:
 
     const char *name;
 
-    // Other needed fields are to be added here.
+    Lock *lock;
+
+    /// One semaphore for each thread waiting, for it to sleep on.
+    List<Semaphore *> *waiters;
 };
@@ -0,0 +1,173 @@
+/// Priority inversion, in the style of the ornamental garden.
+///
+/// A thread of low priority takes an inner lock and works with it.  A
+/// thread a little above takes an outer lock, and waits for the inner one.
+/// Several threads of middle priority then hog the CPU, and a thread of
+/// high priority arrives, wanting the outer lock.
+///
+/// Taken with semaphores, which donate nothing, the low thread does not
+/// run again until the hogs are done, and neither does the high one.
+/// Taken with locks, the high thread donates its priority along the chain
+/// down to the low thread, which finishes right away, and the wait of the
+/// high thread is bounded by the work done with the locks held.
+///
+/// Two cases of donation follow, which should simply run to the end: locks
+/// nested with no one waiting, and a donation along a chain that reaches a
+/// thread already woken by a `Release`, but not yet running.
+
+#include <stdio.h>
+#include "synch.hh"
+#include "system.hh"
+
+static const unsigned HOGS = 3;
+static const unsigned HOG_WORK = 100;   ///< Yields done by each hog.
+static const unsigned LOCKED_WORK = 5;  ///< Yields done holding a lock.
+
+static bool useLocks;
+static Lock *outerLock, *innerLock;
+static Semaphore *outerSemaphore, *innerSemaphore;
+static Semaphore *started, *finished, *go;
+
+static void
+Take(Lock *lock, Semaphore *semaphore) {
+    if (useLocks) lock->Acquire();
+    else semaphore->P();
+}
+
+static void
+Give(Lock *lock, Semaphore *semaphore) {
+    if (useLocks) lock->Release();
+    else semaphore->V();
+}
+
+static void
+Work(unsigned yields) {
+    for (unsigned i = 0; i < yields; i++) currentThread->Yield();
+}
+
+static void
+LowThread(void *arg) {
+    Take(innerLock, innerSemaphore);
+    started->V();
+    Work(LOCKED_WORK);
+    Give(innerLock, innerSemaphore);
+    finished->V();
+}
+
+static void
+ChainThread(void *arg) {
+    Take(outerLock, outerSemaphore);
+    started->V();
+    Take(innerLock, innerSemaphore);
+    Work(LOCKED_WORK);
+    Give(innerLock, innerSemaphore);
+    Give(outerLock, outerSemaphore);
+    finished->V();
+}
+
+static void
+HogThread(void *arg) {
+    Work(HOG_WORK);
+    finished->V();
+}
+
+static void
+HighThread(void *arg) {
+    unsigned long long start = stats->totalTicks;
+    Take(outerLock, outerSemaphore);
+    printf("High priority thread waited %llu ticks, with %s.\n",
+           stats->totalTicks - start, useLocks ? "locks" : "semaphores");
+    Give(outerLock, outerSemaphore);
+    finished->V();
+}
+
+/// Run the scenario once, taking the locks or the semaphores.
+static void
+RunInversion(bool locks) {
+    useLocks = locks;
+
+    // The low and the chain threads are started one by one, so that each
+    // gets its lock before the next one comes.
+    (new Thread("low", DEFAULT_PRIORITY - 2))->Fork(LowThread, nullptr);
+    started->P();
+    (new Thread("chain", DEFAULT_PRIORITY - 1))->Fork(ChainThread, nullptr);
+    started->P();
+    for (unsigned i = 0; i < HOGS; i++) {
+        char *name = new char [16];
+        sprintf(name, "hog %u", i);
+        (new Thread(name))->Fork(HogThread, nullptr);
+    }
+    (new Thread("high", DEFAULT_PRIORITY + 1))->Fork(HighThread, nullptr);
+
+    for (unsigned i = 0; i < HOGS + 3; i++) finished->P();
+}
+
+/// Take the outer lock, then the inner one, and give them back, with no one
+/// waiting for either.
+static void
+Nested() {
+    outerLock->Acquire();
+    innerLock->Acquire();
+    innerLock->Release();
+    outerLock->Release();
+    printf("Nested locks released with no one waiting.\n");
+}
+
+static void
+DonorThread(void *arg) {
+    innerLock->Acquire();
+    innerLock->Release();
+    finished->V();
+}
+
+/// Holds the outer lock until told to go, then gives it to the waiter,
+/// which is left ready but does not run yet, having a lower priority.  A
+/// donor then comes for the inner lock, held by that waiter.
+static void
+ReleaserThread(void *arg) {
+    outerLock->Acquire();
+    started->V();
+    go->P();
+    outerLock->Release();
+    (new Thread("donor", DEFAULT_PRIORITY + 5))->Fork(DonorThread, nullptr);
+    currentThread->Yield();
+    finished->V();
+}
+
+static void
+WaiterThread(void *arg) {
+    innerLock->Acquire();
+    started->V();
+    outerLock->Acquire();
+    outerLock->Release();
+    innerLock->Release();
+    finished->V();
+}
+
+static void
+Chained() {
+    (new Thread("releaser", DEFAULT_PRIORITY + 3))
+        ->Fork(ReleaserThread, nullptr);
+    started->P();
+    (new Thread("waiter", DEFAULT_PRIORITY + 1))->Fork(WaiterThread, nullptr);
+    started->P();
+    go->V();
+    for (unsigned i = 0; i < 3; i++) finished->P();
+    printf("Donation stopped at a waiter already woken.\n");
+}
+
+void
+Inversion() {
+    outerLock      = new Lock("outer");
+    innerLock      = new Lock("inner");
+    outerSemaphore = new Semaphore("outer", 1);
+    innerSemaphore = new Semaphore("inner", 1);
+    started        = new Semaphore("started", 0);
+    finished       = new Semaphore("finished", 0);
+    go             = new Semaphore("go", 0);
+
+    RunInversion(false);
+    RunInversion(true);
+    Nested();
+    Chained();
+}
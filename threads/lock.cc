@@ -1,31 +1,119 @@
 #include "synch.hh"
+#include "system.hh"
 
-/// Dummy functions -- so we can compile our later assignments.
-///
-/// Note -- without a correct implementation of `Condition::Wait`, the test
-/// case in the network assignment will not work!
+/// Longest chain of locks that priority is donated along, in case of a
+/// deadlock.
+static const unsigned MAX_DONATION_DEPTH = 16;
 
-Lock::Lock(const char *debugName)
-{}
+/// Initialize a lock, free to start with.
+///
+/// * `debugName` is an arbitrary name, useful for debugging.
+Lock::Lock(const char *debugName) {
+    name     = debugName;
+    holder   = nullptr;
+    waiters  = new List<Thread *>;
+    nextHeld = nullptr;
+}
 
-Lock::~Lock()
-{}
+/// De-allocate the lock.
+///
+/// Assume no one holds it or is waiting for it!
+Lock::~Lock() {
+    ASSERT(!holder);
+    delete waiters;
+}
 
 const char *
 Lock::GetName() const {
     return name;
 }
 
+/// Wait until the lock is free, then take it.
+///
+/// As with `Semaphore::P`, interrupts are disabled so that this is atomic.
 void
-Lock::Acquire()
-{}
+Lock::Acquire() {
+    ASSERT(!IsHeldByCurrentThread());
 
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+    while (holder) {
+        currentThread->waitingFor = this;
+        AddWaiter(currentThread);
+        Donate(currentThread->GetPriority());
+        currentThread->Sleep();
+    }
+    currentThread->waitingFor = nullptr;
+
+    holder   = currentThread;
+    nextHeld = currentThread->locksHeld;
+    currentThread->locksHeld = this;
+    interrupt->SetLevel(oldLevel);
+}
+
+/// Free the lock, waking up the waiter of highest priority, if any.
+///
+/// If that waiter now has a higher priority than the current thread, the
+/// current thread gives it the CPU.
 void
-Lock::Release()
-{}
+Lock::Release() {
+    ASSERT(IsHeldByCurrentThread());
+
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+    holder = nullptr;
+    Lock **link = &currentThread->locksHeld;
+    while (*link != this) link = &(*link)->nextHeld;
+    *link = nextHeld;
+    nextHeld = nullptr;
+
+    unsigned donated = 0;
+    for (Lock *lock = currentThread->locksHeld; lock; lock = lock->nextHeld)
+        if (lock->GetTopPriority() > donated)
+            donated = lock->GetTopPriority();
+    scheduler->Donate(currentThread, donated);
+
+    Thread *thread = waiters->Pop();
+    if (thread) {
+        thread->waitingFor = nullptr;
+        scheduler->ReadyToRun(thread);
+        if (thread->GetPriority() > currentThread->GetPriority())
+            currentThread->Yield();
+    }
+    interrupt->SetLevel(oldLevel);
+}
 
 bool
-Lock::IsHeldByCurrentThread() const
-{
-    return false; // TODO: complete...
+Lock::IsHeldByCurrentThread() const {
+    return holder == currentThread;
+}
+
+unsigned
+Lock::GetTopPriority() const {
+    if (waiters->IsEmpty()) return 0;
+    return waiters->Head()->GetPriority();
+}
+
+/// A holder that is itself waiting is moved among the waiters of that
+/// lock, as its priority has changed.  One already woken by a `Release`
+/// is no longer among them, and the chain ends there.
+void
+Lock::Donate(unsigned priority) {
+    Lock *lock = this;
+    for (unsigned depth = 0; lock && depth < MAX_DONATION_DEPTH; depth++) {
+        Thread *thread = lock->holder;
+        if (!thread || thread->GetPriority() >= priority) break;
+
+        DEBUG('s', "Donating priority %u to thread %s, holding lock %s.\n",
+              priority, thread->GetName(), lock->GetName());
+        scheduler->Donate(thread, priority);
+        lock = thread->waitingFor;
+        if (!lock || !lock->waiters->Has(thread)) break;
+        lock->waiters->Remove(thread);
+        lock->AddWaiter(thread);
+    }
+}
+
+void
+Lock::AddWaiter(Thread *thread) {
+    ASSERT(thread);
+    waiters->SortedInsert(thread, -(int) thread->GetPriority());
 }
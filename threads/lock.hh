@@ -11,6 +11,14 @@
 ///
 /// For convenience, nobody but the thread that holds the lock can free it.
 /// There is no operation for reading the state of the lock.
+///
+/// Locks avoid priority inversion: a thread waiting for a lock donates its
+/// priority to the holder, and on to the holder of the lock that one waits
+/// for, and so on, so that a thread of low priority holding a lock cannot
+/// be kept from releasing it by threads of middle priority.  The lock is
+/// then given to the waiter of highest priority, and the priority of the
+/// thread releasing it falls back to what the locks it still holds call
+/// for.
 class Lock {
 public:
 
@@ -39,5 +47,23 @@ private:
     /// For debugging.
     const char *name;
 
-    // Add other needed fields here.
+    /// Return the priority of the first thread waiting, or 0 if none.
+    unsigned GetTopPriority() const;
+
+    /// Donate `priority` to the holder of the lock, and on along the chain
+    /// of locks the holders wait for.
+    void Donate(unsigned priority);
+
+    /// Put `thread` among the waiters, in order of priority.
+    void AddWaiter(Thread *thread);
+
+    Thread *holder;  ///< Null while the lock is free.
+
+    /// Threads waiting for the lock, highest priority first.
+    List<Thread *> *waiters;
+
+public:
+
+    /// The next of the locks held by `holder` (cf. `Thread::locksHeld`).
+    Lock *nextHeld;
 };
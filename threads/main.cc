@@ -10,8 +10,17 @@
 /// Usage
 /// =====
 ///
-///     nachos [-d <debugflags>] [-p] [-rs <random seed #>] [-z]
-///            [-s] [-x <nachos file>] [-tc <consoleIn> <consoleOut>]
+///     nachos [-d <debugflags>] [-tr <debugflags> [<trace file>]] [-p]
+///            [-mlfq] [-smp <number of CPUs>] [-sk <stacks kept>]
+///            [-rs <random seed #>] [-rr <event log> | -rp <event log>] [-z]
+///            [-s] [-x <nachos file>] [-bx <workers> <nachos file>...]
+///            [-tc <consoleIn> <consoleOut>] [-tm] [-ta]
+///            [-ck <ticks> <checkpoint file>] [-rx <checkpoint file>]
+///            [-m <physical pages>] [-ps <page size>] [-sq]
+///            [-pf [<coff file>]] [-sp <ticks> [<coff file>]]
+///            [-ic <bytes> <ways> <line bytes> [lru | fifo | random]]
+///            [-dc <bytes> <ways> <line bytes> [lru | fifo | random]]
+///            [-lt <latency preset or file>]
 ///            [-f] [-cp <unix file> <nachos file>] [-pr <nachos file>]
 ///            [-rm <nachos file>] [-ls] [-D] [-tf]
 ///            [-n <network reliability>] [-id <machine id>]
@@ -22,8 +31,24 @@
 ///
 /// * `-d`  -- causes certain debugging messages to be printed (cf.
 ///   `utility.hh`).
+/// * `-tr` -- records the events of the debugging flags given (cf.
+///   `lib/trace.hh`) and saves the latest ones into a file when halting
+///   (`nachos.trace` if none is given), for `.bin/readtrace` to print.
 /// * `-p`  -- enables preemptive multitasking for kernel threads.
+/// * `-mlfq` -- schedules threads as a multilevel feedback queue, moving
+///   those that use up their time slices (given by `-p` or `-rs`) below
+///   those that block early (cf. `Scheduler::UseFeedback`).
+/// * `-smp` -- simulates several CPUs sharing memory (cf.
+///   `threads/multiprocessor.hh`).
+/// * `-sk` -- keeps up to so many stacks of finished threads for new threads
+///   to reuse, instead of the default `DEFAULT_STACK_POOL_SIZE` (cf.
+///   `threads/stack_pool.hh`).
 /// * `-rs` -- causes `Yield` to occur at random (but repeatable) spots.
+/// * `-rr` -- records console input, network packets and the random delays
+///   of the timer into an event log (cf. `machine/.event_log.hh`).
+/// * `-rp` -- replays the events of a log recorded by `-rr`, so that the run
+///   can be repeated exactly, even by another build of Nachos.  Give `-rs`
+///   again if the run recorded used it; its seed no longer matters.
 /// * `-i`  -- prints information about the whole system.
 /// * `-z`  -- prints version and copyright information, and exits.
 ///
@@ -31,8 +56,38 @@
 /// ----------------------
 ///
 /// * `-s`  -- causes user programs to be executed in single-step mode.
+/// * `-m`  -- sets the number of pages of physical memory.
+/// * `-ps` -- sets the size of a page, in bytes (a power of two).
+/// * `-sq` -- counts the instruction sequences run, and prints the most
+///   frequent ones when halting.
+/// * `-pf` -- counts the instructions run by address, and prints the hottest
+///   instructions, functions, basic blocks and data pages when halting;
+///   code is named after the symbols of the COFF file given, if any (such
+///   as `halt.coff` for `halt`, both built in `userland`).
+/// * `-sp` -- samples what runs every so many ticks, without changing the
+///   scheduling, and prints the stacks seen when halting, in the folded
+///   format of flame graph tools; code is named as with `-pf`.
+/// * `-ic` -- models an instruction cache of the size, lines per set and
+///   line size given, replacing the least recently used line unless told
+///   otherwise; misses cost `CACHE_MISS_TIME` ticks, and the hit rate is
+///   printed with the statistics.
+/// * `-dc` -- models a data cache, in the same way as `-ic`.
+/// * `-lt` -- charges user instructions the costs of a latency table, either
+///   a preset (`unit`, `r3000`, `r4000`) or a file (cf.
+///   `machine/.latency_table.hh`).
 /// * `-x`  -- runs a user program.
+/// * `-bx` -- runs a batch of user programs, each in a Nachos of its own,
+///   on up to so many host processes at a time; what each prints is shown
+///   once all are done, in the order given.  Not available with the Nachos
+///   file system or the network, whose host files would be shared.
+/// * `-ck` -- saves a checkpoint of the user program run by a later `-x`
+///   once so many ticks have gone by; the program then goes on.
+/// * `-rx` -- runs a user program from a checkpoint, with the same `-m` and
+///   `-ps` it was saved with.
 /// * `-tc` -- tests the console.
+/// * `-tm` -- tests the performance of the MMU translation policies.
+/// * `-ta` -- checks the multiplication and overflow traps of the simulated
+///   processor against the routines they replaced.
 ///
 /// *FILESYS* options
 /// -----------------
@@ -77,7 +132,12 @@ void Copy(const char *unixFile, const char *nachosFile);
 void Print(const char *file);
 void PerformanceTest(void);
 void StartProcess(const char *file);
+void StartBatch(unsigned workers, char **files, unsigned numFiles);
+void ScheduleCheckpoint(unsigned ticks, const char *file);
+void StartCheckpoint(const char *file);
 void ConsoleTest(const char *in, const char *out);
+void MMUPerformanceTest();
+void ArithmeticTest();
 void MailTest(int networkID);
 
 static inline void
@@ -105,10 +165,18 @@ PrintInfo() {
     printf("Directory file size: " BOLD "%u" DISABLE_BOLD " bytes.\n", DIRECTORY_FILE_SIZE);
     printf("\n");
     printf(ITALIC "MEMORY INFO\n" DISABLE_ITALIC);
-    printf("Page size: " BOLD "%u" DISABLE_BOLD " bytes.\n", PAGE_SIZE);
-    printf("Number of pages: " BOLD "%u" DISABLE_BOLD ".\n", NUM_PHYS_PAGES);
+#ifdef USER_PROGRAM
+    unsigned pageSize     = machine->GetMMU()->GetPageSize();
+    unsigned numPhysPages = machine->GetMMU()->GetNumPhysPages();
+#else
+    unsigned pageSize     = DEFAULT_PAGE_SIZE;
+    unsigned numPhysPages = DEFAULT_NUM_PHYS_PAGES;
+#endif
+    printf("Page size: " BOLD "%u" DISABLE_BOLD " bytes.\n", pageSize);
+    printf("Number of pages: " BOLD "%u" DISABLE_BOLD ".\n", numPhysPages);
     printf("TLB size: " BOLD "%u" DISABLE_BOLD ".\n", TLB_SIZE);
-    printf("Memory size: " BOLD "%u" DISABLE_BOLD " bytes.\n", MEMORY_SIZE);
+    printf("Memory size: " BOLD "%u" DISABLE_BOLD " bytes.\n",
+           numPhysPages * pageSize);
 }
 
 /// Bootstrap the operating system kernel.
@@ -146,6 +214,19 @@ main(int argc, char **argv) {
             ASSERT(argc > 1);
             StartProcess(*(argv + 1));
             argCount = 2;
+        } else if (!strcmp(*argv, "-bx")) {  // Run a batch of programs.
+            ASSERT(argc > 2);
+            for (argCount = 2; argCount < argc; argCount++)
+                if (**(argv + argCount) == '-') break;
+            StartBatch(atoi(*(argv + 1)), argv + 2, argCount - 2);
+        } else if (!strcmp(*argv, "-ck")) {  // Save a checkpoint later.
+            ASSERT(argc > 2);
+            ScheduleCheckpoint(atoi(*(argv + 1)), *(argv + 2));
+            argCount = 3;
+        } else if (!strcmp(*argv, "-rx")) {  // Restore a checkpoint.
+            ASSERT(argc > 1);
+            StartCheckpoint(*(argv + 1));
+            argCount = 2;
         } else if (!strcmp(*argv, "-tc")) {  // Test the console.
             if (argc == 1)
                 ConsoleTest(nullptr, nullptr);
@@ -157,7 +238,10 @@ main(int argc, char **argv) {
             interrupt->Halt();  // Once we start the console, then Nachos
                                 // will loop forever waiting for console
                                 // input.
-        }
+        } else if (!strcmp(*argv, "-tm"))    // Test the MMU performance.
+            MMUPerformanceTest();
+        else if (!strcmp(*argv, "-ta"))      // Test the arithmetic.
+            ArithmeticTest();
 #endif
 #ifdef FILESYS
         if (!strcmp(*argv, "-cp")) {         // Copy from UNIX to Nachos.
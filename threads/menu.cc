@@ -3,6 +3,9 @@
 void ThreadTest();
 void Garden();
 void ProdCons();
+void PriorityTest();
+void Inversion();
+void ForkBenchmark();
 
 void Menu() {
     unsigned opt;
@@ -10,6 +13,9 @@ void Menu() {
     printf("0 - Thread test.\n");
     printf("1 - Ornamental garden.\n");
     printf("2 - Producer/consumer.\n");
+    printf("3 - Dispatch latency.\n");
+    printf("4 - Priority inversion.\n");
+    printf("5 - Fork/finish benchmark.\n");
     printf("Enter an option: ");
     scanf("%u", &opt);
 
@@ -17,6 +23,9 @@ void Menu() {
         case 0: ThreadTest(); break;
         case 1: Garden(); break;
         case 2: ProdCons(); break;
+        case 3: PriorityTest(); break;
+        case 4: Inversion(); break;
+        case 5: ForkBenchmark(); break;
         default: printf("Invalid option.\n");
     }
 }
@@ -0,0 +1,190 @@
+/// Routines to run the kernel on several simulated CPUs.
+///
+/// Copyright (c) 2016-2019 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#include "multiprocessor.hh"
+#include "system.hh"
+
+#include <stdio.h>
+#include <string.h>
+
+/// Body of the idle threads.
+///
+/// Runs with interrupts disabled, taking the threads that are ready, and
+/// giving the CPU up to the others when there are none.
+static void
+IdleLoop(void *dummy) {
+    interrupt->SetLevel(INT_OFF);
+    for (;;) {
+        Thread *nextThread = scheduler->FindNextToRun();
+        if (nextThread)
+            scheduler->Run(nextThread);  // Returns when it sleeps.
+        else
+            multiprocessor->Idle();
+    }
+}
+
+Multiprocessor::Multiprocessor(unsigned n) {
+    ASSERT(n > 0);
+
+    numCpus = n;
+    cpus    = new Cpu [numCpus];
+    current = 0;
+
+    char *name;
+    for (unsigned i = 0; i < numCpus; i++) {
+        name = new char [16];
+        snprintf(name, 16, "idle %u", i);
+        cpus[i].idleThread = new Thread(name);
+        cpus[i].idleThread->Prepare(IdleLoop, nullptr);
+
+        cpus[i].thread    = cpus[i].idleThread;
+        cpus[i].busy      = false;
+        cpus[i].clock     = 0;
+        cpus[i].busyTicks = 0;
+        cpus[i].status.level         = INT_OFF;
+        cpus[i].status.status        = SYSTEM_MODE;
+        cpus[i].status.yieldOnReturn = false;
+#ifdef USER_PROGRAM
+        memset(&cpus[i].context, 0, sizeof cpus[i].context);
+        for (unsigned j = 0; j < TLB_SIZE; j++)
+            cpus[i].context.tlb[j].valid = false;
+#endif
+    }
+
+    // The first CPU is the one that has been running so far.
+    cpus[0].thread = currentThread;
+    cpus[0].busy   = true;
+    cpus[0].clock  = stats->totalTicks;
+}
+
+/// The idle threads are left alone, like any other thread still around
+/// when Nachos halts: one of them may be running this.
+Multiprocessor::~Multiprocessor() {
+    delete [] cpus;
+}
+
+unsigned
+Multiprocessor::GetCurrentCpu() const {
+    return current;
+}
+
+/// The clock of the whole machine is that of the busy CPU furthest behind,
+/// so it never goes back when another CPU takes over.
+void
+Multiprocessor::Advance(unsigned ticks) {
+    cpus[current].clock     += ticks;
+    cpus[current].busyTicks += ticks;
+
+    unsigned n = FurthestBehind();
+    unsigned long long now = n < numCpus ? cpus[n].clock
+                                         : cpus[current].clock;
+    if (now > stats->totalTicks) stats->totalTicks = now;
+}
+
+void
+Multiprocessor::Rotate() {
+    unsigned next = FurthestBehind();
+    if (next < numCpus && next != current) SwitchTo(next);
+}
+
+void
+Multiprocessor::ThreadReady() {
+    if (!cpus[current].busy) {
+        Wake(current);
+        return;
+    }
+    for (unsigned i = 0; i < numCpus; i++)
+        if (!cpus[i].busy) {
+            Wake(i);
+            return;
+        }
+}
+
+Thread *
+Multiprocessor::GetIdleThread() const {
+    return cpus[current].idleThread;
+}
+
+bool
+Multiprocessor::IsIdleThread(const Thread *thread) const {
+    for (unsigned i = 0; i < numCpus; i++)
+        if (cpus[i].idleThread == thread) return true;
+    return false;
+}
+
+/// If every CPU is idle, only an interrupt can bring something to do.
+void
+Multiprocessor::Idle() {
+    ASSERT(currentThread == cpus[current].idleThread);
+    ASSERT(interrupt->GetLevel() == INT_OFF);
+
+    cpus[current].busy = false;
+    while (!cpus[current].busy) {
+        unsigned next = FurthestBehind();
+        if (next < numCpus)
+            SwitchTo(next);
+        else
+            interrupt->Idle();
+    }
+}
+
+void
+Multiprocessor::Print() const {
+    for (unsigned i = 0; i < numCpus; i++)
+        printf("CPU %u: busy %llu ticks.\n", i, cpus[i].busyTicks);
+}
+
+/// Like `Scheduler::Run`, but the thread giving the host up stays on its
+/// CPU, and everything a CPU has of its own goes with it.
+void
+Multiprocessor::SwitchTo(unsigned next) {
+    ASSERT(next < numCpus && next != current);
+
+    Thread *oldThread = currentThread;
+    Cpu *from = &cpus[current];
+    Cpu *to   = &cpus[next];
+
+    from->thread = currentThread;
+    interrupt->SaveCpuStatus(&from->status);
+#ifdef USER_PROGRAM
+    machine->SaveCpuContext(&from->context);
+#endif
+
+    DEBUG('t', "Switching from CPU %u (%s) to CPU %u (%s).\n",
+          current, oldThread->GetName(), next, to->thread->GetName());
+    current = next;
+    interrupt->RestoreCpuStatus(to->status);
+#ifdef USER_PROGRAM
+    machine->RestoreCpuContext(to->context);
+#endif
+    currentThread = to->thread;
+
+    SWITCH(oldThread, currentThread);
+
+    // Another CPU may have left a finished thread behind.
+    if (threadToBeDestroyed) {
+        delete threadToBeDestroyed;
+        threadToBeDestroyed = nullptr;
+    }
+}
+
+unsigned
+Multiprocessor::FurthestBehind() const {
+    unsigned n = numCpus;
+    for (unsigned i = 0; i < numCpus; i++)
+        if (cpus[i].busy && (n == numCpus || cpus[i].clock < cpus[n].clock))
+            n = i;
+    return n;
+}
+
+void
+Multiprocessor::Wake(unsigned n) {
+    ASSERT(n < numCpus);
+
+    DEBUG('t', "Waking CPU %u up.\n", n);
+    cpus[n].busy = true;
+    if (cpus[n].clock < stats->totalTicks) cpus[n].clock = stats->totalTicks;
+}
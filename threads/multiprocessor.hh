@@ -0,0 +1,100 @@
+/// Data structures for running the kernel on several simulated CPUs.
+///
+/// Each CPU has its own interrupt status, its own registers and TLB (when
+/// running user programs), and a thread it is running; physical memory,
+/// devices and the ready list are shared.  The CPUs are simulated one at a
+/// time, on the host thread Nachos runs on: every time a CPU advances
+/// simulated time with interrupts enabled, the CPU furthest behind in time
+/// takes over.  This makes runs repeatable, and keeps sections run with
+/// interrupts disabled atomic, as they are on a uniprocessor.
+///
+/// Every CPU keeps its own clock.  `stats->totalTicks` is the clock of the
+/// busy CPU furthest behind, which is how far the whole machine has
+/// certainly got; `systemTicks` and `userTicks` add up the work of all the
+/// CPUs.
+///
+/// A CPU with nothing to run switches to an idle thread of its own, which
+/// is never put on the ready list.  `Scheduler::ReadyToRun` wakes an idle
+/// CPU up, if there is any, so that it takes the thread.
+///
+/// Copyright (c) 2016-2019 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_THREADS_MULTIPROCESSOR__HH
+#define NACHOS_THREADS_MULTIPROCESSOR__HH
+
+#include "thread.hh"
+#include "machine/interrupt.hh"
+
+class Multiprocessor {
+public:
+
+    /// Simulate `numCpus` CPUs, the first of which runs `currentThread`;
+    /// the others start idle.
+    Multiprocessor(unsigned numCpus);
+
+    ~Multiprocessor();
+
+    /// Return the number of the CPU running now.
+    unsigned GetCurrentCpu() const;
+
+    /// Advance the clock of the CPU running by `ticks`.
+    void Advance(unsigned ticks);
+
+    /// Let the busy CPU furthest behind in time run, if it is not this one.
+    ///
+    /// Returns when this CPU gets to run again.
+    void Rotate();
+
+    /// Called by `Scheduler::ReadyToRun`: wake up an idle CPU, if there is
+    /// any, preferring this one.
+    void ThreadReady();
+
+    /// Return the idle thread of the CPU running, for it to switch to when
+    /// there is no thread ready.
+    Thread *GetIdleThread() const;
+
+    /// Return whether `thread` is the idle thread of some CPU.
+    bool IsIdleThread(const Thread *thread) const;
+
+    /// Called by the idle thread of the CPU running when there is no thread
+    /// ready: let other CPUs run, or wait for an interrupt if all are idle.
+    ///
+    /// Returns once this CPU has been woken up.
+    void Idle();
+
+    /// Print how busy each CPU was.
+    void Print() const;
+
+private:
+
+    struct Cpu {
+        Thread *thread;  ///< The thread it runs, while another CPU runs.
+        Thread *idleThread;
+        bool busy;  ///< False while it only runs its idle thread.
+        unsigned long long clock;  ///< Its own simulated time.
+        unsigned long long busyTicks;  ///< Ticks it was not idle for.
+        CpuStatus status;
+#ifdef USER_PROGRAM
+        CpuContext context;
+#endif
+    };
+
+    /// Hand the host over to CPU `next`, returning when this CPU gets it
+    /// back.
+    void SwitchTo(unsigned next);
+
+    /// Return the busy CPU furthest behind in time (the lowest numbered
+    /// among equals), or `numCpus` if all are idle.
+    unsigned FurthestBehind() const;
+
+    /// Make CPU `n` busy, with its clock at the current time.
+    void Wake(unsigned n);
+
+    Cpu *cpus;
+    unsigned numCpus;
+    unsigned current;  ///< The CPU running now.
+};
+
+#endif
@@ -9,8 +9,10 @@
 /// needed to wait for a lock, and the lock was busy, we would end up calling
 /// `FindNextToRun`, and that would put us in an infinite loop.
 ///
-/// Very simple implementation -- no priorities, straight FIFO.  Might need
-/// to be improved in later assignments.
+/// The thread run is always one of the highest priority ready, the first
+/// to become ready among those.  A bitmap of the priorities with threads
+/// ready makes finding it take the same time however many threads and
+/// priorities there are.
 ///
 /// Copyright (c) 1992-1993 The Regents of the University of California.
 ///               2016-2018 Docentes de la Universidad Nacional de Rosario.
@@ -20,18 +22,27 @@
 #include "scheduler.hh"
 #include "system.hh"
 
-/// Initialize the list of ready but not running threads to empty.
+/// Initialize the lists of ready but not running threads to empty.
 Scheduler::Scheduler() {
-    readyList = new List<Thread *>;
+    for (unsigned i = 0; i < NUM_PRIORITIES; i++)
+        readyList[i] = new List<Thread *>;
+    readyLevels = 0;
+
+    feedback   = false;
+    dispatches = 0;
+    for (unsigned i = 0; i < NUM_FEEDBACK_LEVELS; i++)
+        readyAtLevel[i] = 0;
 }
 
-/// De-allocate the list of ready threads.
+/// De-allocate the lists of ready threads.
 Scheduler::~Scheduler() {
-    delete readyList;
+    for (unsigned i = 0; i < NUM_PRIORITIES; i++)
+        delete readyList[i];
 }
 
 /// Mark a thread as ready, but not running.
-/// Put it on the ready list, for later scheduling onto the CPU.
+/// Put it on the ready list of its priority, for later scheduling onto the
+/// CPU.  On a multiprocessor, an idle CPU is woken up to take it.
 ///
 /// * `thread` is the thread to be put on the ready list.
 void
@@ -40,18 +51,188 @@ Scheduler::ReadyToRun(Thread *thread) {
     DEBUG('t', "Putting thread %s on ready list.\n", thread->GetName());
 
     thread->SetStatus(READY);
-    readyList->Append(thread);
+    AddReady(thread);
+    if (multiprocessor) multiprocessor->ThreadReady();
 }
 
 /// Return the next thread to be scheduled onto the CPU.
 ///
-/// If there are no ready threads, return null.
+/// If there are no ready threads of priority `minPriority` or higher,
+/// return null.
 ///
 /// Side effect: thread is removed from the ready list.
 Thread *
-Scheduler::FindNextToRun() {
+Scheduler::FindNextToRun(unsigned minPriority) {
     if (debug.IsEnabled('T')) Print();
-    return readyList->Pop();
+    if (readyLevels == 0) return nullptr;
+
+    unsigned priority = sizeof readyLevels * 8 - 1
+                        - __builtin_clz(readyLevels);
+    if (priority < minPriority) return nullptr;
+
+    Thread *thread = readyList[priority]->Pop();
+    if (readyList[priority]->IsEmpty())
+        readyLevels &= ~(1u << priority);
+    if (feedback) {
+        unsigned level = FeedbackLevel(thread);
+        readyAtLevel[level]--;
+        stats->numFeedbackDispatches[level]++;
+        if (++dispatches == FEEDBACK_BOOST_PERIOD) {
+            Boost();
+            RaiseToBase(thread);
+        }
+    }
+    return thread;
+}
+
+bool
+Scheduler::IsReadyListEmpty() const {
+    return readyLevels == 0;
+}
+
+void
+Scheduler::SetPriority(Thread *thread, unsigned priority) {
+    ASSERT(thread);
+    ASSERT(priority < NUM_PRIORITIES);
+
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+    bool ready = TakeIfReady(thread);
+    thread->SetPriority(priority);
+    if (ready) AddReady(thread);
+    interrupt->SetLevel(oldLevel);
+}
+
+void
+Scheduler::Donate(Thread *thread, unsigned priority) {
+    ASSERT(thread);
+    ASSERT(priority < NUM_PRIORITIES);
+
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+    bool ready = TakeIfReady(thread);
+    thread->SetDonatedPriority(priority);
+    if (ready) AddReady(thread);
+    interrupt->SetLevel(oldLevel);
+}
+
+void
+Scheduler::UseFeedback() {
+    feedback = true;
+}
+
+/// Moves `thread` down a level, unless it is at the bottom one already.
+void
+Scheduler::SliceExpired(Thread *thread) {
+    ASSERT(thread);
+
+    if (!feedback) return;
+    unsigned priority = thread->GetOwnPriority();
+    if (priority > 0 && FeedbackLevel(thread) < NUM_FEEDBACK_LEVELS - 1) {
+        DEBUG('t', "Moving thread %s down to priority %u.\n",
+              thread->GetName(), priority - 1);
+        thread->SetPriority(priority - 1);
+    }
+}
+
+/// Moves `thread` up a level, unless it is at its base priority already.
+void
+Scheduler::Blocked(Thread *thread) {
+    ASSERT(thread);
+
+    if (!feedback) return;
+    unsigned priority = thread->GetOwnPriority();
+    if (priority < thread->GetBasePriority()) {
+        DEBUG('t', "Moving thread %s up to priority %u.\n",
+              thread->GetName(), priority + 1);
+        thread->SetPriority(priority + 1);
+    }
+}
+
+/// Threads above their base priority, as with `SetPriority`, are at level
+/// 0, and threads set further below it than the feedback queue would move
+/// them are at the bottom level; donations are left aside.
+unsigned
+Scheduler::FeedbackLevel(const Thread *thread) {
+    ASSERT(thread);
+
+    unsigned base = thread->GetBasePriority();
+    unsigned priority = thread->GetOwnPriority();
+    if (priority >= base) return 0;
+    if (base - priority >= NUM_FEEDBACK_LEVELS)
+        return NUM_FEEDBACK_LEVELS - 1;
+    return base - priority;
+}
+
+void
+Scheduler::RaiseToBase(Thread *thread) {
+    ASSERT(thread);
+
+    if (thread->GetOwnPriority() < thread->GetBasePriority())
+        thread->SetPriority(thread->GetBasePriority());
+}
+
+/// Return whether `thread` was ready, in which case it is taken off its
+/// ready list.
+bool
+Scheduler::TakeIfReady(Thread *thread) {
+    ASSERT(thread);
+
+    if (!readyList[thread->GetPriority()]->Has(thread)) return false;
+    RemoveReady(thread);
+    return true;
+}
+
+void
+Scheduler::AddReady(Thread *thread) {
+    ASSERT(thread);
+
+    unsigned priority = thread->GetPriority();
+    readyList[priority]->Append(thread);
+    readyLevels |= 1u << priority;
+    if (feedback) {
+        unsigned level = FeedbackLevel(thread);
+        if (++readyAtLevel[level] > stats->maxFeedbackReady[level])
+            stats->maxFeedbackReady[level] = readyAtLevel[level];
+    }
+}
+
+void
+Scheduler::RemoveReady(Thread *thread) {
+    ASSERT(thread);
+
+    unsigned priority = thread->GetPriority();
+    readyList[priority]->Remove(thread);
+    if (readyList[priority]->IsEmpty())
+        readyLevels &= ~(1u << priority);
+    if (feedback) readyAtLevel[FeedbackLevel(thread)]--;
+}
+
+/// Blocked threads are left where they are: they are not starving, and
+/// moving up when they block brings them back up soon enough.  The thread
+/// being dispatched is raised by `FindNextToRun`.
+///
+/// The ready threads are taken off their lists first, and put back in the
+/// order they were, highest priority first, so that no thread is passed
+/// over by one that was behind it.
+void
+Scheduler::Boost() {
+    DEBUG('t', "Boosting every thread to its base priority.\n");
+    dispatches = 0;
+
+    List<Thread *> boosted;
+    for (unsigned i = NUM_PRIORITIES; i-- > 0;)
+        while (!readyList[i]->IsEmpty()) {
+            Thread *thread = readyList[i]->Pop();
+            readyAtLevel[FeedbackLevel(thread)]--;
+            boosted.Append(thread);
+        }
+    readyLevels = 0;
+
+    while (!boosted.IsEmpty()) {
+        Thread *thread = boosted.Pop();
+        RaiseToBase(thread);
+        AddReady(thread);
+    }
+    RaiseToBase(currentThread);
 }
 
 /// Dispatch the CPU to `nextThread`.
@@ -116,7 +297,7 @@ Scheduler::Run(Thread *nextThread) {
 }
 
 /// Print the scheduler state -- in other words, the contents of the ready
-/// list.
+/// lists, highest priority first.
 ///
 /// For debugging.
 static void
@@ -128,6 +309,10 @@ ThreadPrint(Thread *t) {
 void
 Scheduler::Print() {
     printf("Ready list contents: ");
-    readyList->Apply(ThreadPrint);
+    for (unsigned i = NUM_PRIORITIES; i-- > 0;)
+        if (readyLevels & 1u << i) {
+            printf("[%u] ", i);
+            readyList[i]->Apply(ThreadPrint);
+        }
     printf("\n");
 }
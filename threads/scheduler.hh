@@ -1,6 +1,7 @@
 /// Data structures for the thread dispatcher and scheduler.
 ///
-/// Primarily, the list of threads that are ready to run.
+/// Primarily, the lists of threads that are ready to run, one for each
+/// priority.
 ///
 /// Copyright (c) 1992-1993 The Regents of the University of California.
 ///               2016-2018 Docentes de la Universidad Nacional de Rosario.
@@ -12,6 +13,10 @@
 
 #include "thread.hh"
 #include "lib/list.hh"
+#include "machine/statistics.hh"
+
+/// Dispatches between boosts of the multilevel feedback queue.
+const unsigned FEEDBACK_BOOST_PERIOD = 64;
 
 /// The following class defines the scheduler/dispatcher abstraction --
 /// the data structures and operations needed to keep track of which
@@ -19,28 +24,84 @@
 class Scheduler {
 public:
 
-    /// Initialize list of ready threads.
+    /// Initialize lists of ready threads.
     Scheduler();
 
-    /// De-allocate ready list.
+    /// De-allocate ready lists.
     ~Scheduler();
 
     /// Thread can be dispatched.
     void ReadyToRun(Thread *thread);
 
-    /// Dequeue first thread on the ready list, if any, and return thread.
-    Thread *FindNextToRun();
+    /// Dequeue first thread of the highest priority ready, if any and if
+    /// that priority is at least `minPriority`, and return thread.
+    Thread *FindNextToRun(unsigned minPriority = 0);
 
     /// Cause `nextThread` to start running.
     void Run(Thread *nextThread);
 
+    /// Return whether no thread is waiting to run.
+    bool IsReadyListEmpty() const;
+
+    /// Change the own priority of `thread`, or the priority donated to it,
+    /// moving it to its new ready list if it is ready.
+    void SetPriority(Thread *thread, unsigned priority);
+    void Donate(Thread *thread, unsigned priority);
+
+    /// Schedule as a multilevel feedback queue from now on.
+    ///
+    /// A thread preempted at the end of its time slice is moved down one
+    /// level, and one that blocks before it is moved back up, so that
+    /// threads waiting for I/O run ahead of those using the CPU.  Levels
+    /// are counted down from the base priority of each thread, for
+    /// `NUM_FEEDBACK_LEVELS` levels.  Every `FEEDBACK_BOOST_PERIOD`
+    /// dispatches, the threads ready or running go back up to their base
+    /// priority, so that none of them starves.
+    ///
+    /// The time slice is that of whatever preempts threads: the `-p`
+    /// preemptive scheduler, or the timer of `-rs`.
+    void UseFeedback();
+
+    /// Called when the time slice of `thread`, running, is over.
+    void SliceExpired(Thread *thread);
+
+    /// Called when `thread`, running, blocks.
+    void Blocked(Thread *thread);
+
     // Print contents of ready list.
     void Print();
 
 private:
 
-    // Queue of threads that are ready to run, but not running.
-    List<Thread*> *readyList;
+    /// Queues of threads that are ready to run, but not running, one for
+    /// each priority.
+    List<Thread*> *readyList[NUM_PRIORITIES];
+
+    /// Bit `i` is set when `readyList[i]` is not empty.
+    unsigned readyLevels;
+
+    /// Return the feedback level of `thread`: how far below its base
+    /// priority it is.
+    static unsigned FeedbackLevel(const Thread *thread);
+
+    /// Put `thread` back at its base priority, if it is below it.
+    static void RaiseToBase(Thread *thread);
+
+    /// Take `thread` off its ready list, if it is on one.
+    bool TakeIfReady(Thread *thread);
+
+    /// Put `thread` on the ready list of its priority, or take it off.
+    void AddReady(Thread *thread);
+    void RemoveReady(Thread *thread);
+
+    /// Put the threads ready or running back at their base priority.
+    void Boost();
+
+    bool feedback;  ///< Whether scheduling as a multilevel feedback queue.
+    unsigned dispatches;  ///< Since the last boost.
+
+    /// Number of threads ready at each feedback level.
+    unsigned readyAtLevel[NUM_FEEDBACK_LEVELS];
 
 };
 
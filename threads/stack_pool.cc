@@ -0,0 +1,39 @@
+/// Routines to reuse the execution stacks of threads.
+///
+/// Copyright (c) 2016-2019 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#include "stack_pool.hh"
+
+StackPool::StackPool(unsigned stackCapacity, unsigned stackSize) {
+    ASSERT(stackSize > 0);
+
+    capacity  = stackCapacity;
+    size      = stackSize;
+    numStacks = 0;
+    stacks    = new char * [capacity];
+}
+
+StackPool::~StackPool() {
+    while (numStacks > 0) DeallocBoundedArray(stacks[--numStacks], size);
+    delete [] stacks;
+}
+
+/// The stack kept last is given first, as it is the likeliest to still be
+/// in the host caches.
+char *
+StackPool::Get() {
+    if (numStacks > 0) return stacks[--numStacks];
+    return AllocBoundedArray(size);
+}
+
+void
+StackPool::Put(char *stack) {
+    ASSERT(stack);
+
+    if (numStacks < capacity)
+        stacks[numStacks++] = stack;
+    else
+        DeallocBoundedArray(stack, size);
+}
@@ -0,0 +1,45 @@
+/// Data structures for reusing the execution stacks of threads.
+///
+/// Every stack is allocated with `AllocBoundedArray`, with a page on each
+/// side that the host does not let be touched, to catch stack overflows.
+/// Setting up and tearing down those pages is costly, so the stacks of
+/// finished threads are kept, with their guard pages still in place, to
+/// be given to the threads forked next.  Only so many are kept; the rest
+/// are freed.
+///
+/// Copyright (c) 2016-2019 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_THREADS_STACKPOOL__HH
+#define NACHOS_THREADS_STACKPOOL__HH
+
+#include "lib/utility.hh"
+
+/// Stacks kept when no other number is given.
+const unsigned DEFAULT_STACK_POOL_SIZE = 64;
+
+class StackPool {
+public:
+
+    /// Keep up to `capacity` stacks of `size` bytes; 0 keeps none.
+    StackPool(unsigned capacity, unsigned size);
+
+    /// Free the stacks kept.
+    ~StackPool();
+
+    /// Return a stack, kept or new.
+    char *Get();
+
+    /// Take back a stack returned by `Get`, keeping it if there is room.
+    void Put(char *stack);
+
+private:
+
+    char **stacks;  ///< The stacks kept.
+    unsigned numStacks;
+    unsigned capacity;
+    unsigned size;
+};
+
+#endif
@@ -3,9 +3,7 @@
 /// Data structures for synchronizing threads.
 ///
 /// Three synchronization mechanisms are defined here: semaphores, locks and
-/// condition variables. Only semaphores are implemented; for locks and
-/// condition variables, only the interface is provided. Precisely, the first
-/// task involves developing this implementation.
+/// condition variables.  Locks donate priority to avoid priority inversion.
 ///
 /// All synchronization objects have a `name` parameter in the constructor;
 /// its only aim is to ease debugging the program.
@@ -24,11 +24,18 @@ Interrupt *interrupt;         ///< Interrupt status.
 Statistics *stats;            ///< Performance metrics.
 Timer *timer;                 ///< The hardware timer device, for invoking
                               ///< context switches.
+EventLog *eventLog = nullptr; ///< Outside events being recorded or
+                              ///< replayed.
+Multiprocessor *multiprocessor = nullptr;  ///< The CPUs, if more than one.
+StackPool *stackPool;         ///< Stacks of finished threads, for reuse.
 
 // 2007, Jose Miguel Santos Espino
 PreemptiveScheduler *preemptiveScheduler = nullptr;
 const long long DEFAULT_TIME_SLICE = 50000;
 
+/// Number of events kept by `-tr`.
+static const unsigned TRACE_CAPACITY = 1 << 16;
+
 #ifdef FILESYS_NEEDED
 FileSystem *fileSystem;
 #endif
@@ -64,9 +71,36 @@ extern void Cleanup();
 ///   it needs it or not.
 static void
 TimerInterruptHandler(void *dummy) {
-    if (interrupt->GetStatus() != IDLE_MODE) interrupt->YieldOnReturn();
+    if (interrupt->GetStatus() != IDLE_MODE) {
+        scheduler->SliceExpired(currentThread);
+        interrupt->YieldOnReturn();
+    }
 }
 
+#ifdef USER_PROGRAM
+/// The shape of a cache to model, as given by `-ic` or `-dc`.
+struct CacheArgs {
+    unsigned size;
+    unsigned ways;
+    unsigned lineSize;
+    ReplacementPolicy policy;
+};
+
+/// Parse the arguments of the `-ic` or `-dc` at `argv` into `cache`, and
+/// return how many there were, counting the flag itself.
+static int
+ParseCacheArgs(int argc, char **argv, CacheArgs *cache) {
+    ASSERT(argc > 3);
+
+    cache->size     = atoi(*(argv + 1));
+    cache->ways     = atoi(*(argv + 2));
+    cache->lineSize = atoi(*(argv + 3));
+    if (argc > 4 && ParseReplacementPolicy(*(argv + 4), &cache->policy))
+        return 5;
+    return 4;
+}
+#endif
+
 /// Initialize Nachos global data structures.
 ///
 /// Interpret command line arguments in order to determine flags for the
@@ -85,7 +119,14 @@ Initialize(int argc, char **argv) {
 
     int argCount;
     const char *debugArgs = "";
+    const char *traceArgs = nullptr;
+    const char *traceFile = "nachos.trace";
+    const char *eventLogFile = nullptr;
+    bool replayEvents = false;
     bool randomYield = false;
+    bool feedbackScheduling = false;
+    unsigned numCpus = 1;
+    unsigned numStacks = DEFAULT_STACK_POOL_SIZE;
 
     // 2007, Jose Miguel Santos Espino
     bool preemptiveScheduling = false;
@@ -93,6 +134,16 @@ Initialize(int argc, char **argv) {
 
 #ifdef USER_PROGRAM
     bool debugUserProg = false;  // Single step user program.
+    bool profileSequences = false;  // Count instruction sequences.
+    bool profileExecution = false;  // Count instructions by address.
+    const char *symbolFile = nullptr;  // Symbols for the profile.
+    unsigned samplePeriod = 0;  // Ticks between samples, if sampling.
+    const char *sampleSymbolFile = nullptr;  // Symbols for the samples.
+    CacheArgs iCache = { 0, 0, 0, LRU_REPLACEMENT };  // Instruction cache.
+    CacheArgs dCache = { 0, 0, 0, LRU_REPLACEMENT };  // Data cache.
+    const char *latencyTable = nullptr;  // Preset or file of costs.
+    unsigned numPhysPages = DEFAULT_NUM_PHYS_PAGES;
+    unsigned pageSize = DEFAULT_PAGE_SIZE;
 #endif
 #ifdef FILESYS_NEEDED
     unsigned format = false;  // Format disk.
@@ -111,6 +162,28 @@ Initialize(int argc, char **argv) {
                 debugArgs = *(argv + 1);
                 argCount = 2;
             }
+        } else if (!strcmp(*argv, "-tr")) {
+            ASSERT(argc > 1);
+            traceArgs = *(argv + 1);
+            argCount = 2;
+            if (argc > 2 && **(argv + 2) != '-') {
+                traceFile = *(argv + 2);
+                argCount = 3;
+            }
+        } else if (!strcmp(*argv, "-rr") || !strcmp(*argv, "-rp")) {
+            ASSERT(argc > 1);
+            eventLogFile = *(argv + 1);
+            replayEvents = !strcmp(*argv, "-rp");
+            argCount = 2;
+        } else if (!strcmp(*argv, "-smp")) {
+            ASSERT(argc > 1);
+            numCpus = atoi(*(argv + 1));
+            ASSERT(numCpus > 0);
+            argCount = 2;
+        } else if (!strcmp(*argv, "-sk")) {
+            ASSERT(argc > 1);
+            numStacks = atoi(*(argv + 1));
+            argCount = 2;
         } else if (!strcmp(*argv, "-rs")) {
             ASSERT(argc > 1);
             RandomInit(atoi(*(argv + 1)));  // Initialize pseudo-random
@@ -118,6 +191,8 @@ Initialize(int argc, char **argv) {
             randomYield = true;
             argCount = 2;
         }
+        else if (!strcmp(*argv, "-mlfq"))
+            feedbackScheduling = true;
         // 2007, Jose Miguel Santos Espino
         else if (!strcmp(*argv, "-p")) {
             preemptiveScheduling = true;
@@ -131,6 +206,40 @@ Initialize(int argc, char **argv) {
 #ifdef USER_PROGRAM
         if (!strcmp(*argv, "-s"))
             debugUserProg = true;
+        else if (!strcmp(*argv, "-m")) {
+            ASSERT(argc > 1);
+            numPhysPages = atoi(*(argv + 1));
+            argCount = 2;
+        } else if (!strcmp(*argv, "-ps")) {
+            ASSERT(argc > 1);
+            pageSize = atoi(*(argv + 1));
+            argCount = 2;
+        } else if (!strcmp(*argv, "-sq"))
+            profileSequences = true;
+        else if (!strcmp(*argv, "-pf")) {
+            profileExecution = true;
+            if (argc > 1 && **(argv + 1) != '-') {
+                symbolFile = *(argv + 1);
+                argCount = 2;
+            }
+        } else if (!strcmp(*argv, "-sp")) {
+            ASSERT(argc > 1);
+            samplePeriod = atoi(*(argv + 1));
+            ASSERT(samplePeriod > 0);
+            argCount = 2;
+            if (argc > 2 && **(argv + 2) != '-') {
+                sampleSymbolFile = *(argv + 2);
+                argCount = 3;
+            }
+        } else if (!strcmp(*argv, "-ic"))
+            argCount = ParseCacheArgs(argc, argv, &iCache);
+        else if (!strcmp(*argv, "-dc"))
+            argCount = ParseCacheArgs(argc, argv, &dCache);
+        else if (!strcmp(*argv, "-lt")) {
+            ASSERT(argc > 1);
+            latencyTable = *(argv + 1);
+            argCount = 2;
+        }
 #endif
 #ifdef FILESYS_NEEDED
         if (!strcmp(*argv, "-f"))
@@ -153,12 +262,21 @@ Initialize(int argc, char **argv) {
 
     debug.SetFlags(debugArgs);  // Initialize `DEBUG` messages.
     stats = new Statistics;     // Collect statistics.
+    if (traceArgs)              // Record trace events.
+        trace.Start(traceArgs, traceFile, &stats->totalTicks,
+                    TRACE_CAPACITY);
+    if (eventLogFile)           // Record or replay outside events.
+        eventLog = new EventLog(eventLogFile, replayEvents);
     interrupt = new Interrupt;  // Start up interrupt handling.
     scheduler = new Scheduler;  // Initialize the ready queue.
+    if (feedbackScheduling)     // Move threads by how they use the CPU.
+        scheduler->UseFeedback();
     if (randomYield)            // Start the timer (if needed).
         timer = new Timer(TimerInterruptHandler, 0, randomYield);
 
     threadToBeDestroyed = nullptr;
+    stackPool = new StackPool(numStacks,  // Reuse thread stacks.
+                              STACK_SIZE * sizeof (HostMemoryAddress));
 
     // We did not explicitly allocate the current thread we are running in.
     // But if it ever tries to give up the CPU, we better have a `Thread`
@@ -166,6 +284,9 @@ Initialize(int argc, char **argv) {
     currentThread = new Thread("main");
     currentThread->SetStatus(RUNNING);
 
+    if (numCpus > 1)            // Simulate several CPUs.
+        multiprocessor = new Multiprocessor(numCpus);
+
     interrupt->Enable();
     CallOnUserAbort(Cleanup);  // If user hits ctl-C...
 
@@ -177,7 +298,20 @@ Initialize(int argc, char **argv) {
 
 #ifdef USER_PROGRAM
     Debugger *d = debugUserProg ? new Debugger : nullptr;
-    machine = new Machine(d);  // This must come first.
+    // This must come first.
+    machine = new Machine(d, numPhysPages, pageSize);
+    if (profileSequences) machine->ProfileSequences();
+    if (profileExecution) machine->ProfileExecution(symbolFile);
+    if (samplePeriod > 0)
+        machine->ProfileSamples(samplePeriod, sampleSymbolFile);
+    if (multiprocessor) machine->StartMultiprocessing();
+    if (iCache.size > 0)
+        machine->ModelInstructionCache(iCache.size, iCache.ways,
+                                       iCache.lineSize, iCache.policy);
+    if (dCache.size > 0)
+        machine->ModelDataCache(dCache.size, dCache.ways, dCache.lineSize,
+                                dCache.policy);
+    if (latencyTable) machine->ModelLatencies(latencyTable);
     SetExceptionHandlers();
 #endif
 
@@ -218,9 +352,13 @@ Cleanup() {
     delete synchDisk;
 #endif
 
+    delete multiprocessor;
+    delete stackPool;
     delete timer;
     delete scheduler;
     delete interrupt;
+    delete eventLog;
 
+    trace.Save();
     exit(0);
 }
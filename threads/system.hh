@@ -9,11 +9,14 @@
 #define NACHOS_THREADS_SYSTEM__HH
 
 #include "thread.hh"
+#include "multiprocessor.hh"
 #include "scheduler.hh"
+#include "stack_pool.hh"
 #include "lib/utility.hh"
 #include "machine/interrupt.hh"
 #include "machine/statistics.hh"
 #include "machine/timer.hh"
+#include "machine/.event_log.hh"
 
 /// Initialization and cleanup routines.
 
@@ -29,6 +32,10 @@ extern Scheduler *scheduler;         ///< The ready list.
 extern Interrupt *interrupt;         ///< Interrupt status.
 extern Statistics *stats;            ///< Performance metrics.
 extern Timer *timer;                 ///< The hardware alarm clock.
+extern EventLog *eventLog;           ///< Outside events being recorded or
+                                     ///< replayed, if any.
+extern Multiprocessor *multiprocessor;  ///< The CPUs, if more than one.
+extern StackPool *stackPool;         ///< Stacks of finished threads.
 
 #ifdef USER_PROGRAM
 #include "machine/machine.hh"
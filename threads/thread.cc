@@ -34,8 +34,15 @@ IsThreadStatus(ThreadStatus s) {
 /// `Thread::Fork`.
 ///
 /// * `threadName` is an arbitrary string, useful for debugging.
-Thread::Thread(const char *threadName) {
+/// * `threadPriority` is the priority it is scheduled with.
+Thread::Thread(const char *threadName, unsigned threadPriority) {
+    ASSERT(threadPriority < NUM_PRIORITIES);
+
     name     = threadName;
+    priority = ownPriority = basePriority = threadPriority;
+    donatedPriority = 0;
+    waitingFor = nullptr;
+    locksHeld  = nullptr;
     stackTop = nullptr;
     stack    = nullptr;
     status   = JUST_CREATED;
@@ -56,8 +63,7 @@ Thread::~Thread() {
     DEBUG('t', "Deleting thread %s.\n", name);
     ASSERT(this != currentThread);
 
-    if (stack)
-        DeallocBoundedArray((char *) stack, STACK_SIZE * sizeof *stack);
+    if (stack) stackPool->Put((char *) stack);
 
 #ifdef USER_PROGRAM
     ASSERT(space);
@@ -93,6 +99,13 @@ Thread::Fork(VoidFunctionPtr func, void *arg) {
     interrupt->SetLevel(oldLevel);
 }
 
+void
+Thread::Prepare(VoidFunctionPtr func, void *arg) {
+    DEBUG('t', "Preparing thread %s.\n", name);
+    ASSERT(func);
+    StackAllocate(func, arg);
+}
+
 /// Check a thread's stack to see if it has overrun the space that has been
 /// allocated for it.  If we had a smarter compiler, we would not need to
 /// worry about this, but we do not.
@@ -122,6 +135,37 @@ Thread::GetName() const {
     return name;
 }
 
+unsigned
+Thread::GetPriority() const {
+    return priority;
+}
+
+unsigned
+Thread::GetOwnPriority() const {
+    return ownPriority;
+}
+
+unsigned
+Thread::GetBasePriority() const {
+    return basePriority;
+}
+
+void
+Thread::SetPriority(unsigned newPriority) {
+    ASSERT(newPriority < NUM_PRIORITIES);
+
+    ownPriority = newPriority;
+    priority = ownPriority > donatedPriority ? ownPriority : donatedPriority;
+}
+
+void
+Thread::SetDonatedPriority(unsigned newPriority) {
+    ASSERT(newPriority < NUM_PRIORITIES);
+
+    donatedPriority = newPriority;
+    priority = ownPriority > donatedPriority ? ownPriority : donatedPriority;
+}
+
 void
 Thread::Print() const {
     printf(BOLD "%s " DISABLE_BOLD, name);
@@ -149,12 +193,13 @@ Thread::Finish() {
     // Not reached.
 }
 
-/// Relinquish the CPU if any other thread is ready to run.
+/// Relinquish the CPU if any other thread of the same priority or higher is
+/// ready to run.
 ///
-/// If so, put the thread on the end of the ready list, so that it will
-/// eventually be re-scheduled.
+/// If so, put the thread on the end of the ready list of its priority, so
+/// that it will eventually be re-scheduled.
 ///
-/// NOTE: returns immediately if no other thread on the ready queue.
+/// NOTE: returns immediately if no such thread on the ready queue.
 /// Otherwise returns when the thread eventually works its way to the front
 /// of the ready list and gets re-scheduled.
 ///
@@ -164,14 +209,18 @@ Thread::Finish() {
 /// are called with interrupts disabled.
 ///
 /// Similar to `Thread::Sleep`, but a little different.
+///
+/// The idle threads of a multiprocessor never go on the ready list, so they
+/// do not yield.
 void
 Thread::Yield() {
     DEBUG('t', "Yielding thread %s.\n", GetName());
     ASSERT(this == currentThread);
+    if (multiprocessor && multiprocessor->IsIdleThread(this)) return;
 
     IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
 
-    Thread *nextThread = scheduler->FindNextToRun();
+    Thread *nextThread = scheduler->FindNextToRun(priority);
     if (nextThread) {
         scheduler->ReadyToRun(this);
         scheduler->Run(nextThread);
@@ -188,7 +237,8 @@ Thread::Yield() {
 /// NOTE: if there are no threads on the ready queue, that means we have no
 /// thread to run.  `Interrupt::Idle` is called to signify that we should
 /// idle the CPU until the next I/O interrupt occurs (the only thing that
-/// could cause a thread to become ready to run).
+/// could cause a thread to become ready to run).  On a multiprocessor, the
+/// CPU switches to its idle thread instead, so that other CPUs can go on.
 ///
 /// NOTE: we assume interrupts are already disabled, because it is called
 /// from the synchronization routines which must disable interrupts for
@@ -202,8 +252,14 @@ Thread::Sleep() {
 
     Thread *nextThread;
     status = BLOCKED;
-    while ((nextThread = scheduler->FindNextToRun()) == nullptr)
+    scheduler->Blocked(this);
+    while ((nextThread = scheduler->FindNextToRun()) == nullptr) {
+        if (multiprocessor) {
+            nextThread = multiprocessor->GetIdleThread();
+            break;
+        }
         interrupt->Idle();  // No one to run, wait for an interrupt.
+    }
 
     scheduler->Run(nextThread);  // Returns when we have been signalled.
 }
@@ -237,7 +293,7 @@ void
 Thread::StackAllocate(VoidFunctionPtr func, void *arg) {
     ASSERT(func);
 
-    stack = (HostMemoryAddress *) AllocBoundedArray(STACK_SIZE * sizeof *stack);
+    stack = (HostMemoryAddress *) stackPool->Get();
 
     // i386 & MIPS & SPARC stack works from high addresses to low addresses.
     stackTop = stack + STACK_SIZE - 4;  // -4 to be on the safe side!
@@ -45,6 +45,8 @@
 #include "userprog/address_space.hh"
 #endif
 
+class Lock;
+
 /// CPU register state to be saved on context switch.
 ///
 /// x86 processors needs 9 32-bit registers, whereas x64 has 8 extra
@@ -58,6 +60,17 @@ const unsigned MACHINE_STATE_SIZE = 17;
 /// WATCH OUT IF THIS IS NOT BIG ENOUGH!!!!!
 const unsigned STACK_SIZE = 4 * 1024;
 
+/// Number of priority levels.
+///
+/// Priorities go from 0, the lowest, to `NUM_PRIORITIES - 1`; the
+/// scheduler keeps a bitmap of the levels with threads ready, one bit per
+/// level, so there can be no more levels than bits in an `unsigned`.
+const unsigned NUM_PRIORITIES = 32;
+
+/// Priority of threads not given one, which leaves room both above and
+/// below.
+const unsigned DEFAULT_PRIORITY = NUM_PRIORITIES / 2;
+
 /// Thread state.
 enum ThreadStatus {
     JUST_CREATED,
@@ -73,7 +86,12 @@ enum ThreadStatus {
 /// Every thread has:
 /// * an execution stack for activation records (`stackTop` and `stack`);
 /// * space to save CPU registers while not running (`machineState`);
-/// * a `status` (running/ready/blocked).
+/// * a `status` (running/ready/blocked);
+/// * a `priority`: the scheduler always runs a thread of the highest
+///   priority ready.  It is the higher of the thread's own priority, which
+///   starts as the base priority given and may then be moved by the
+///   scheduler, and the priority donated to it by the threads waiting for
+///   the locks it holds.
 ///
 ///  Some threads also belong to a user address space; threads that only run
 ///  in the kernel have a null address space.
@@ -92,7 +110,7 @@ private:
 public:
 
     /// Initialize a `Thread`.
-    Thread(const char *debugName);
+    Thread(const char *debugName, unsigned priority = DEFAULT_PRIORITY);
 
     /// Deallocate a Thread.
     ///
@@ -105,6 +123,11 @@ public:
     /// Make thread run `(*func)(arg)`.
     void Fork(VoidFunctionPtr func, void *arg);
 
+    /// Make thread run `(*func)(arg)` once switched to, without putting it
+    /// on the ready list; for threads that are dispatched in other ways,
+    /// such as the idle threads of a multiprocessor.
+    void Prepare(VoidFunctionPtr func, void *arg);
+
     /// Relinquish the CPU if any other thread is runnable.
     void Yield();
 
@@ -121,6 +144,24 @@ public:
 
     const char *GetName() const;
 
+    /// Return the priority the thread is scheduled with.
+    unsigned GetPriority() const;
+
+    /// Return the priority of the thread, leaving donations aside.
+    unsigned GetOwnPriority() const;
+
+    /// Return the priority the thread was created with.
+    unsigned GetBasePriority() const;
+
+    /// Change the own priority of the thread, or the priority donated to
+    /// it (0 for none).
+    ///
+    /// Only change the fields: while the thread is ready, use
+    /// `Scheduler::SetPriority` or `Scheduler::Donate`, which also move it
+    /// to its new ready list.
+    void SetPriority(unsigned newPriority);
+    void SetDonatedPriority(unsigned newPriority);
+
     void Print() const;
 
 private:
@@ -136,10 +177,26 @@ private:
 
     const char *name;
 
+    /// From 0 to `NUM_PRIORITIES - 1`; higher runs first.
+    unsigned priority;
+    unsigned ownPriority;
+    unsigned donatedPriority;
+    unsigned basePriority;
+
     /// Allocate a stack for thread.  Used internally by `Fork`.
     void StackAllocate(VoidFunctionPtr func, void *arg);
 
+public:
+
+    /// The lock this thread is waiting for, if any, and the first of the
+    /// locks it holds, chained through `Lock::nextHeld`; kept by `Lock`,
+    /// to find where to donate priority.
+    Lock *waitingFor;
+    Lock *locksHeld;
+
 #ifdef USER_PROGRAM
+private:
+
     /// User-level CPU register state.
     ///
     /// A thread running a user program actually has *two* sets of CPU
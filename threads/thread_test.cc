@@ -4,14 +4,21 @@
 /// between themselves by calling `Thread::Yield`, to illustrate the inner
 /// workings of the thread system.
 ///
+/// Also, a test of how soon a thread of higher priority is dispatched, and
+/// a benchmark of forking threads.
+///
 /// Copyright (c) 1992-1993 The Regents of the University of California.
 ///               2007-2009 Universidad de Las Palmas de Gran Canaria.
 ///               2016-2017 Docentes de la Universidad Nacional de Rosario.
 /// All rights reserved.  See `copyright.h` for copyright notice and
 /// limitation of liability and disclaimer of warranty provisions.
 
+#include "synch.hh"
 #include "system.hh"
 
+#include <string.h>
+#include <time.h>
+
 /// Loops yielding the CPU to another ready thread each iteration.
 void
 SimpleThread(void* args) {
@@ -50,3 +57,122 @@ ThreadTest() {
 
     printf("End of thread test.\n");
 }
+
+/// Threads loading the CPU in the dispatch latency test, and requests
+/// served by the service thread in each round.
+static const unsigned BATCH_THREADS = 4;
+static const unsigned REQUESTS = 20;
+
+/// Iterations between requests, plenty for each to be served before the
+/// next is made.
+static const unsigned REQUEST_PERIOD = 10;
+
+/// State shared by the threads of a round of the dispatch latency test.
+struct LatencyRound {
+    Semaphore *request;   ///< Signalled by a batch thread to make a request.
+    Semaphore *finished;  ///< Signalled by every thread when done.
+    unsigned long long sentAt;  ///< When the last request was made.
+    unsigned long long total;   ///< Ticks waited by all requests.
+    unsigned long long worst;   ///< Ticks waited by the slowest one.
+};
+
+/// Keeps the CPU busy, the first one of them also making the requests.
+static void
+BatchThread(void *arg) {
+    LatencyRound *round = (LatencyRound *) arg;
+    bool client = !strcmp(currentThread->GetName(), "batch 0");
+
+    for (unsigned i = 0; i < (REQUESTS + 1) * REQUEST_PERIOD; i++) {
+        if (client && i % REQUEST_PERIOD == 0
+              && i / REQUEST_PERIOD < REQUESTS) {
+            round->sentAt = stats->totalTicks;
+            round->request->V();
+        }
+        currentThread->Yield();
+    }
+    round->finished->V();
+}
+
+/// Serves the requests, measuring how long each waited to be dispatched.
+static void
+ServiceThread(void *arg) {
+    LatencyRound *round = (LatencyRound *) arg;
+
+    for (unsigned i = 0; i < REQUESTS; i++) {
+        round->request->P();
+        unsigned long long latency = stats->totalTicks - round->sentAt;
+        round->total += latency;
+        if (latency > round->worst) round->worst = latency;
+    }
+    round->finished->V();
+}
+
+/// Run the service thread at `priority` against the batch threads, at the
+/// default priority, and print how long its requests waited.
+static void
+RunLatencyRound(unsigned priority) {
+    LatencyRound round;
+    round.request  = new Semaphore("request", 0);
+    round.finished = new Semaphore("finished", 0);
+    round.sentAt   = 0;
+    round.total    = 0;
+    round.worst    = 0;
+
+    (new Thread("service", priority))->Fork(ServiceThread, &round);
+    for (unsigned i = 0; i < BATCH_THREADS; i++) {
+        char *name = new char [16];
+        sprintf(name, "batch %u", i);
+        (new Thread(name))->Fork(BatchThread, &round);
+    }
+    for (unsigned i = 0; i < BATCH_THREADS + 1; i++)
+        round.finished->P();
+
+    printf("Service at priority %u: latency %llu ticks on average, "
+           "%llu at worst.\n", priority, round.total / REQUESTS, round.worst);
+
+    delete round.request;
+    delete round.finished;
+}
+
+/// Measure how long a service thread takes to be dispatched once it has a
+/// request, while several batch threads keep the CPU busy: first at the
+/// priority of the batch threads, then above it.
+void
+PriorityTest() {
+    printf("Starting dispatch latency test, %u batch threads.\n",
+           BATCH_THREADS);
+    RunLatencyRound(DEFAULT_PRIORITY);
+    RunLatencyRound(DEFAULT_PRIORITY + 1);
+    printf("End of dispatch latency test.\n");
+}
+
+/// Threads forked by the fork/finish benchmark, and how many of them are
+/// alive at once.
+static const unsigned BENCHMARK_THREADS = 100000;
+static const unsigned BENCHMARK_BATCH = 16;
+
+static void
+EmptyThread(void *arg) {
+    ((Semaphore *) arg)->V();
+}
+
+/// Fork short-lived threads that do nothing, a batch at a time, and print
+/// how many are forked and finished each second of host time.
+void
+ForkBenchmark() {
+    Semaphore *finished = new Semaphore("finished", 0);
+
+    printf("Forking %u threads, %u at a time.\n",
+           BENCHMARK_THREADS, BENCHMARK_BATCH);
+    clock_t start = clock();
+    for (unsigned i = 0; i < BENCHMARK_THREADS; i += BENCHMARK_BATCH) {
+        for (unsigned j = 0; j < BENCHMARK_BATCH; j++)
+            (new Thread("empty"))->Fork(EmptyThread, finished);
+        for (unsigned j = 0; j < BENCHMARK_BATCH; j++)
+            finished->P();
+    }
+    double seconds = (double) (clock() - start) / CLOCKS_PER_SEC;
+    printf("%.0f threads per second.\n", BENCHMARK_THREADS / seconds);
+
+    delete finished;
+}
@@ -15,7 +15,7 @@ typedef DebuggerCommandManager DCM;
 
 static inline void
 PrintPrompt() {
-    const char PROMPT[] = "%u> ";
+    const char PROMPT[] = "%llu> ";
 
     printf(PROMPT, stats->totalTicks);
     fflush(stdout);
@@ -112,8 +112,9 @@ CommandDump(char **args, void *extra) {
         return DCM::RUN_RESULT_STAY;
     }
 
-    int rv = fwrite(machine->GetMMU()->mainMemory, 1, MEMORY_SIZE, f);
-    if (rv != MEMORY_SIZE) {
+    unsigned memorySize = machine->GetMMU()->GetMemorySize();
+    unsigned rv = fwrite(machine->GetMMU()->mainMemory, 1, memorySize, f);
+    if (rv != memorySize) {
         fprintf(stderr, ERROR("Error: write to file %s did not succeed.\n"), path);
         return DCM::RUN_RESULT_STAY;
     }
@@ -179,7 +180,7 @@ CommandPrint(char **args, void *extra) {
             if (e == NO_EXCEPTION) PrintChar(c);
             else printf("Exception on memory read: %u\n", e);
         } else if (strcmp(end, "@p") == 0) {
-            if (address >= MEMORY_SIZE) {
+            if (address >= machine->GetMMU()->GetMemorySize()) {
                 fprintf(stderr, ERROR("Error: address %u is too big.\n"), address);
                 return DCM::RUN_RESULT_STAY;
             }
@@ -237,7 +238,8 @@ CommandTick(char **args, void *runUntilTime_) {
         return DCM::RUN_RESULT_STAY;
     }
 
-    unsigned *runUntilTime = (unsigned *) runUntilTime_;
+    unsigned long long *runUntilTime
+      = (unsigned long long *) runUntilTime_;
     *runUntilTime = stats->totalTicks + num;
     return DCM::RUN_RESULT_STEP;
 }
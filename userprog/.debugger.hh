@@ -24,8 +24,9 @@ private:
     char buffer[BUFFER_SIZE];
     DebuggerCommandManager manager;
     int previousRegisters[NUM_TOTAL_REGS];
-    unsigned runUntilTime;  ///< Drop back into the debugger when simulated
-                            ///< time reaches this value.
+    unsigned long long runUntilTime;  ///< Drop back into the debugger when
+                                      ///< simulated time reaches this
+                                      ///< value.
 };
 
 #endif
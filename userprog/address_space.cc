@@ -39,13 +39,14 @@ AddressSpace::AddressSpace(OpenFile *executable) {
     InitSegments(); // Initialize segments metadata.
 
     // How big is address space?
+    unsigned pageSize = machine->GetMMU()->GetPageSize();
     unsigned size = codeSize + initDataSize + uninitDataSize + USER_STACK_SIZE;
       // We need to increase the size to leave room for the stack.
-    numPages = DivRoundUp(size, PAGE_SIZE);
-    size = numPages * PAGE_SIZE;
+    numPages = DivRoundUp(size, pageSize);
+    size = numPages * pageSize;
 
     DEBUG('a', "Initializing address space, num pages %u, size %u.\n", numPages, size);
-    ASSERT(numPages <= NUM_PHYS_PAGES);
+    ASSERT(numPages <= machine->GetMMU()->GetNumPhysPages());
       // Check we are not trying to run anything too big -- at least until we have virtual memory.
 
     // First, set up the translation.
@@ -79,6 +80,18 @@ AddressSpace::AddressSpace(OpenFile *executable) {
     }
 }
 
+AddressSpace::AddressSpace(TranslationEntry *table, unsigned size) {
+    ASSERT(table || size == 0);
+
+    pageTable = table;
+    numPages  = size;
+
+    // The segments are only needed to load the program.
+    codeSize = codeVirtualAddr = codeInFileAddr = 0;
+    initDataSize = initDataVirtualAddr = initDataInFileAddr = 0;
+    uninitDataSize = 0;
+}
+
 /// Deallocate an address space.
 ///
 /// Nothing for now!
@@ -106,9 +119,10 @@ AddressSpace::InitRegisters() {
     // Set the stack register to the end of the address space, where we
     // allocated the stack; but subtract off a bit, to make sure we do not
     // accidentally reference off the end!
-    machine->WriteRegister(STACK_REG, numPages * PAGE_SIZE - 16);
+    unsigned stack = numPages * machine->GetMMU()->GetPageSize() - 16;
+    machine->WriteRegister(STACK_REG, stack);
 
-    DEBUG('a', "Initializing stack register to %u.\n", numPages * PAGE_SIZE - 16);
+    DEBUG('a', "Initializing stack register to %u.\n", stack);
 }
 
 /// On a context switch, save any machine state, specific to this address
@@ -127,4 +141,5 @@ void
 AddressSpace::RestoreState() {
     machine->GetMMU()->pageTable     = pageTable;
     machine->GetMMU()->pageTableSize = numPages;
+    machine->GetMMU()->InvalidateTranslationCache();
 }
@@ -28,6 +28,14 @@ public:
     /// * `executable` is the open file that corresponds to the program.
     AddressSpace(OpenFile *executable);
 
+    /// Create an address space for a program already in memory, as after
+    /// restoring a checkpoint.
+    ///
+    /// * `table` is the page table of the program, which the address space
+    ///   takes ownership of.
+    /// * `size` is the number of pages in `table`.
+    AddressSpace(TranslationEntry *table, unsigned size);
+
     /// De-allocate an address space.
     ~AddressSpace();
 
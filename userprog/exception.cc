@@ -71,6 +71,8 @@ DefaultHandler(ExceptionType et) {
 static void
 SyscallHandler(ExceptionType _et) {
     int scid = machine->ReadRegister(2);
+    TRACE(TRACE_SYSCALL, scid, machine->ReadRegister(4),
+          machine->ReadRegister(5));
 
     switch (scid) {
         case SC_HALT:
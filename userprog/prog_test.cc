@@ -1,7 +1,8 @@
 /// Test routines for demonstrating that Nachos can load a user program and
 /// execute it.
 ///
-/// Also, routines for testing the Console hardware device.
+/// Also, routines for testing the Console hardware device, for measuring
+/// the MMU, and for checking the arithmetic of the simulated processor.
 ///
 /// Copyright (c) 1992-1993 The Regents of the University of California.
 ///               2016-2017 Docentes de la Universidad Nacional de Rosario.
@@ -9,10 +10,17 @@
 /// limitation of liability and disclaimer of warranty provisions.
 
 #include "address_space.hh"
+#include "machine/.arithmetic.hh"
 #include "machine/console.hh"
 #include "threads/synch.hh"
 #include "threads/system.hh"
 
+#include <limits.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
 /// Run a user program.
 ///
 /// Open the executable, load it into memory, and jump to it.
@@ -39,6 +47,178 @@ StartProcess(const char *filename) {
                      // exits by doing the system call `Exit`.
 }
 
+/// Checkpoints are only saved while the user program is the only thread
+/// and no I/O is in progress, since only the machine is saved, not the
+/// kernel; when that is not the case, it is tried again a little later.
+static const unsigned CHECKPOINT_RETRY = 100;
+
+/// File to save the next checkpoint into.
+static const char *checkpointFile;
+
+static void
+CheckpointHandler(void *dummy) {
+    if (interrupt->GetInterruptedStatus() != USER_MODE
+          || !currentThread->space || !scheduler->IsReadyListEmpty()
+          || interrupt->IsDevicePending()) {
+        interrupt->Schedule(CheckpointHandler, nullptr, CHECKPOINT_RETRY,
+                            CHECKPOINT_INT);
+        return;
+    }
+
+    machine->SaveCheckpoint(checkpointFile);
+    printf("Checkpoint saved into %s at tick %llu.\n",
+           checkpointFile, stats->totalTicks);
+}
+
+/// Save a checkpoint of the user program into the file `filename` once
+/// `ticks` ticks have gone by, so that it can be restored with
+/// `StartCheckpoint`.
+void
+ScheduleCheckpoint(unsigned ticks, const char *filename) {
+    ASSERT(ticks > 0);
+    ASSERT(filename);
+
+    checkpointFile = filename;
+    interrupt->Schedule(CheckpointHandler, nullptr, ticks, CHECKPOINT_INT);
+}
+
+/// Run a user program from a checkpoint saved by `ScheduleCheckpoint`.
+void
+StartCheckpoint(const char *filename) {
+    ASSERT(filename);
+
+    TranslationEntry *pageTable;
+    unsigned          numPages;
+    if (!machine->RestoreCheckpoint(filename, &pageTable, &numPages)) {
+        printf("Unable to restore checkpoint %s.\n", filename);
+        return;
+    }
+
+    AddressSpace *space = new AddressSpace(pageTable, numPages);
+    currentThread->space = space;
+    space->RestoreState();  // Load page table register.
+
+    machine->Run();  // Go back to the user program.
+    ASSERT(false);
+}
+
+/// A program of a batch, and where its output goes until it is printed.
+struct BatchJob {
+    const char *filename;
+    FILE *out;
+    FILE *err;
+    int pid;     ///< The host process running it, 0 once it is done.
+    int status;  ///< As given by `waitpid`.
+};
+
+/// Copy what was written into `from` onto `to`.
+static void
+CopyOutput(FILE *from, FILE *to) {
+    char buffer[4096];
+    size_t n;
+
+    rewind(from);
+    while ((n = fread(buffer, 1, sizeof buffer, from)) > 0)
+        fwrite(buffer, 1, n, to);
+}
+
+/// Wait for whichever of the first `numJobs` of `jobs` exits first, and
+/// mark it as done by clearing its `pid`.
+///
+/// Any other child of Nachos that exits meanwhile is not one of ours, and
+/// is left aside.
+static void
+WaitForJob(BatchJob *jobs, unsigned numJobs) {
+    ASSERT(jobs);
+
+    for (;;) {
+        int status;
+        int pid = wait(&status);
+        ASSERT(pid > 0);
+        for (unsigned i = 0; i < numJobs; i++)
+            if (jobs[i].pid == pid) {
+                jobs[i].pid = 0;
+                jobs[i].status = status;
+                return;
+            }
+    }
+}
+
+/// Run each of the user programs `filenames`, as `StartProcess` would, in a
+/// Nachos of its own, on up to `workers` host processes at a time.
+///
+/// Each program gets a copy of the whole kernel, which serializes its own
+/// system calls and interrupts, so they can be run on as many host cores
+/// as there are, with no locking.  The copies share the files the host had
+/// open when they were made, though: with the Nachos file system, they
+/// would all read and write the one open `DISK` file, at the same offset,
+/// and with the network, they would all use the one socket.  Batches are
+/// only run with the stub file system and no network, where the programs
+/// share nothing but the host file system.
+///
+/// What each program prints is held back until all are done, and then
+/// printed whole, in the order given, so that the output does not depend
+/// on which finished first.  A new program is started as soon as any
+/// worker is done, however long the others take.
+void
+StartBatch(unsigned workers, char **filenames, unsigned numFiles) {
+    ASSERT(workers > 0);
+    ASSERT(filenames);
+
+#if defined(FILESYS) || defined(NETWORK)
+    printf("Batches cannot be run with the Nachos file system or the "
+           "network.\n");
+    return;
+#endif
+
+    BatchJob *jobs = new BatchJob [numFiles];
+    unsigned running = 0;
+
+    for (unsigned i = 0; i < numFiles; i++) {
+        jobs[i].filename = filenames[i];
+        jobs[i].out = tmpfile();
+        jobs[i].err = tmpfile();
+        jobs[i].status = 0;
+        ASSERT(jobs[i].out && jobs[i].err);
+
+        if (running == workers) {
+            WaitForJob(jobs, i);
+            running--;
+        }
+
+        fflush(stdout);  // Or the child would print it again.
+        fflush(stderr);
+        jobs[i].pid = fork();
+        ASSERT(jobs[i].pid >= 0);
+        if (jobs[i].pid == 0) {
+            dup2(fileno(jobs[i].out), STDOUT_FILENO);
+            dup2(fileno(jobs[i].err), STDERR_FILENO);
+            StartProcess(filenames[i]);
+            Cleanup();  // Only reached if the program could not be started.
+        }
+        running++;
+    }
+    for (; running > 0; running--) WaitForJob(jobs, numFiles);
+
+    for (unsigned i = 0; i < numFiles; i++) {
+        printf("=== %s", jobs[i].filename);
+        if (WIFSIGNALED(jobs[i].status))
+            printf(" (killed by signal %d)", WTERMSIG(jobs[i].status));
+        else if (WEXITSTATUS(jobs[i].status) != 0)
+            printf(" (exit status %d)", WEXITSTATUS(jobs[i].status));
+        printf("\n");
+        fflush(stdout);
+        CopyOutput(jobs[i].out, stdout);
+        CopyOutput(jobs[i].err, stderr);
+        fflush(stdout);
+        fflush(stderr);
+        fclose(jobs[i].out);
+        fclose(jobs[i].err);
+    }
+
+    delete [] jobs;
+}
+
 /// Data structures needed for the console test.
 ///
 /// Threads making I/O requests wait on a `Semaphore` to delay until the I/O
@@ -80,3 +260,215 @@ ConsoleTest(const char *in, const char *out) {
         if (ch == 'q') return;  // If `q`, then quit.
     }
 }
+
+/// Number of translations timed for each MMU policy.
+static const unsigned MMU_TEST_ACCESSES = 10000000;
+
+/// Return the average host time, in nanoseconds, that `mmu` takes to
+/// translate an address, and to read a word through `ReadMem`.
+///
+/// The addresses go round the first `TLB_SIZE` pages, so that a TLB never
+/// misses and both policies do the same work.
+template <class Policy>
+static void
+TimeMMU(BasicMMU<Policy> *mmu, double *translate, double *read) {
+    ASSERT(mmu);
+    ASSERT(translate);
+    ASSERT(read);
+
+    const unsigned span = TLB_SIZE * mmu->GetPageSize();
+    unsigned physAddr;
+    int value;
+
+    clock_t start = clock();
+    for (unsigned i = 0; i < MMU_TEST_ACCESSES; i++) {
+        ExceptionType e = mmu->Translate(i * 4 % span, &physAddr, 4, false);
+        ASSERT(e == NO_EXCEPTION);
+    }
+    *translate = (double) (clock() - start) * 1e9 / CLOCKS_PER_SEC
+                 / MMU_TEST_ACCESSES;
+
+    start = clock();
+    for (unsigned i = 0; i < MMU_TEST_ACCESSES; i++) {
+        ExceptionType e = mmu->ReadMem(i * 4 % span, 4, &value);
+        ASSERT(e == NO_EXCEPTION);
+    }
+    *read = (double) (clock() - start) * 1e9 / CLOCKS_PER_SEC
+            / MMU_TEST_ACCESSES;
+}
+
+/// Compare the speed of the translation policies of the MMU.
+///
+/// Builds an MMU of each kind, maps the same pages in both, and times
+/// translations and reads with each of them.
+void
+MMUPerformanceTest() {
+    TranslationEntry entries[TLB_SIZE];
+    for (unsigned i = 0; i < TLB_SIZE; i++) {
+        entries[i].virtualPage  = i;
+        entries[i].physicalPage = i;
+        entries[i].valid        = true;
+        entries[i].readOnly     = false;
+        entries[i].use          = false;
+        entries[i].dirty        = false;
+    }
+
+    double translate, read;
+
+    BasicMMU<PageTablePolicy> *pageTableMMU
+      = new BasicMMU<PageTablePolicy>(DEFAULT_NUM_PHYS_PAGES,
+                                      DEFAULT_PAGE_SIZE);
+    pageTableMMU->pageTable     = entries;
+    pageTableMMU->pageTableSize = TLB_SIZE;
+    TimeMMU(pageTableMMU, &translate, &read);
+    printf("Page table: %.1f ns per translation, %.1f ns per read.\n",
+           translate, read);
+    delete pageTableMMU;
+
+    BasicMMU<TlbPolicy> *tlbMMU
+      = new BasicMMU<TlbPolicy>(DEFAULT_NUM_PHYS_PAGES, DEFAULT_PAGE_SIZE);
+    for (unsigned i = 0; i < TLB_SIZE; i++) tlbMMU->tlb[i] = entries[i];
+    TimeMMU(tlbMMU, &translate, &read);
+    printf("TLB: %.1f ns per translation, %.1f ns per read.\n",
+           translate, read);
+    delete tlbMMU;
+}
+
+/// The multiplication the simulator did before `Mult` took a host 64-bit
+/// product, kept as it was to check the new one against; only `-a` is done
+/// in unsigned arithmetic, so that `INT_MIN` does not overflow on the host.
+static void
+ShiftAndAddMult(int a, int b, bool signedArith, int *hiPtr, int *loPtr) {
+    if (a == 0 || b == 0) {
+        *hiPtr = *loPtr = 0;
+        return;
+    }
+
+    bool negative = false;
+    if (signedArith) {
+        if (a < 0) {
+            negative = !negative;
+            a = (int) -(unsigned) a;
+        }
+        if (b < 0) {
+            negative = !negative;
+            b = (int) -(unsigned) b;
+        }
+    }
+
+    unsigned bLo = b;
+    unsigned bHi = 0;
+    unsigned lo = 0;
+    unsigned hi = 0;
+    for (unsigned i = 0; i < 32; i++) {
+        if (a & 1) {
+            lo += bLo;
+            if (lo < bLo) hi += 1;
+            hi += bHi;
+            if ((a & 0xFFFFFFFE) == 0) break;
+        }
+        bHi <<= 1;
+        if (bLo & 0x80000000) bHi |= 1;
+        bLo <<= 1;
+        a >>= 1;
+    }
+
+    if (negative) {
+        hi = ~hi;
+        lo = ~lo;
+        lo++;
+        if (lo == 0) hi++;
+    }
+    *hiPtr = (int) hi;
+    *loPtr = (int) lo;
+}
+
+/// The overflow checks of `ADD`, `ADDI` and `SUB` before they used the
+/// host builtins, on sums and differences wrapped in unsigned arithmetic.
+static bool
+SignBitAddOverflows(int a, int b) {
+    int sum = (int) ((unsigned) a + (unsigned) b);
+    return !((a ^ b) & 0x80000000) && (a ^ sum) & 0x80000000;
+}
+
+static bool
+SignBitSubOverflows(int a, int b) {
+    int diff = (int) ((unsigned) a - (unsigned) b);
+    return (a ^ b) & 0x80000000 && (a ^ diff) & 0x80000000;
+}
+
+/// Return the number of ways in which the arithmetic of the simulator
+/// gives something else than the routines it replaced for `a` and `b`,
+/// printing them.
+static unsigned
+CompareArithmetic(int a, int b) {
+    unsigned mismatches = 0;
+
+    for (unsigned s = 0; s < 2; s++) {
+        int hi, lo, oldHi, oldLo;
+        Mult(a, b, s == 1, &hi, &lo);
+        ShiftAndAddMult(a, b, s == 1, &oldHi, &oldLo);
+        if (hi != oldHi || lo != oldLo) {
+            printf("%s %d, %d: HI %d LO %d, was HI %d LO %d.\n",
+                   s == 1 ? "MULT" : "MULTU", a, b, hi, lo, oldHi, oldLo);
+            mismatches++;
+        }
+    }
+
+    int result;
+    bool overflow = AddOverflows(a, b, &result);
+    if (overflow != SignBitAddOverflows(a, b)
+          || result != (int) ((unsigned) a + (unsigned) b)) {
+        printf("ADD %d, %d: %d, overflow %d.\n", a, b, result, overflow);
+        mismatches++;
+    }
+    overflow = SubOverflows(a, b, &result);
+    if (overflow != SignBitSubOverflows(a, b)
+          || result != (int) ((unsigned) a - (unsigned) b)) {
+        printf("SUB %d, %d: %d, overflow %d.\n", a, b, result, overflow);
+        mismatches++;
+    }
+    return mismatches;
+}
+
+/// Random operand pairs compared by the arithmetic test.
+static const unsigned ARITHMETIC_TEST_CASES = 1000000;
+
+/// Compare the multiplication and the overflow checks of the simulator
+/// with the routines they replaced, on every pair of edge operands and on
+/// random pairs.
+///
+/// `ADDI` adds a sign-extended immediate with the same check as `ADD`, so
+/// immediates are among the edge operands.  Random operands are shifted
+/// right by a random amount, so that small magnitudes are covered as well.
+void
+ArithmeticTest() {
+    static const int EDGES[] = {
+        0, 1, -1, 2, -2, 3, INT_MAX, INT_MIN, INT_MAX - 1, INT_MIN + 1,
+        (int) UINT_MAX, 0x7FFF, -0x8000, 0xFFFF, 0x10000, -0x10000,
+        0x40000000, -0x40000000
+    };
+    const unsigned numEdges = sizeof EDGES / sizeof *EDGES;
+
+    unsigned cases = 0, mismatches = 0;
+    for (unsigned i = 0; i < numEdges; i++)
+        for (unsigned j = 0; j < numEdges; j++, cases++)
+            mismatches += CompareArithmetic(EDGES[i], EDGES[j]);
+
+    unsigned seed = 0x2545F491;  // Xorshift, apart from `Random`.
+    unsigned words[3];
+    for (unsigned n = 0; n < ARITHMETIC_TEST_CASES; n++, cases++) {
+        for (unsigned i = 0; i < 3; i++) {
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            words[i] = seed;
+        }
+        int a = (int) words[0] >> (words[2] & 31);
+        int b = (int) words[1] >> (words[2] >> 5 & 31);
+        mismatches += CompareArithmetic(a, b);
+    }
+
+    printf("Arithmetic test: %u operand pairs, %u mismatches.\n",
+           cases, mismatches);
+}